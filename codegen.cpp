@@ -1,11 +1,25 @@
 #include "node.h"
 #include "codegen.h"
 #include "parser.hpp"
+#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <sys/mman.h>
 
 using namespace std;
 
+LLVMContext MyContext;
+
 /* Compile the AST into a module */
 void CodeGenContext::generateCode(NBlock& root)
+{
+	beginCode();
+	root.codeGen(*this); /* emit bytecode for the toplevel block */
+	endCode();
+}
+
+/* Starts main, which the top-level statements are compiled into */
+void CodeGenContext::beginCode()
 {
 	std::cout << "Generating code...\n";
 	
@@ -13,12 +27,27 @@ void CodeGenContext::generateCode(NBlock& root)
 	vector<Type*> argTypes;
 	FunctionType *ftype = FunctionType::get(Type::getVoidTy(MyContext), makeArrayRef(argTypes), false);
 	mainFunction = Function::Create(ftype, GlobalValue::ExternalLinkage, "main", module);
+	// main只会被调用一次，有了norecurse，FunctionAttrs可以继续推导它调用的内部函数
+	mainFunction->addFnAttr(Attribute::NoRecurse);
 	BasicBlock *bblock = BasicBlock::Create(MyContext, "entry", mainFunction, 0);
 	
 	/* Push a new variable/block context */
 	pushBlock(bblock);
-	root.codeGen(*this); /* emit bytecode for the toplevel block */
+}
+
+/* Compiles one top-level statement as soon as the parser has it. Returns
+   false when codegen still needs the statement's tree afterwards: the
+   compile-time evaluator runs int functions from their AST. */
+bool CodeGenContext::generateTopLevel(NStatement& stmt)
+{
+	Function *function = dyn_cast_or_null<Function>(stmt.codeGen(*this));
+	return !(isa<NFunctionDeclaration>(&stmt) && function != NULL && constFunctions.count(function));
+}
 
+/* Finishes main and the module: verification, the runtime, optimization */
+void CodeGenContext::endCode()
+{
+	releaseStorage(mainFunction);
 	ReturnInst::Create(MyContext, this->currentBlock());//当前块，不再是bblock，块已经分离过了
 	popBlock();
 	
@@ -27,16 +56,75 @@ void CodeGenContext::generateCode(NBlock& root)
 	 */
 	std::cout << "Code is generated.\n";
 	// module->dump();
+	if (verifyModule(*module, &errs())) {
+		std::cerr << "Error: generated module is broken" << endl;
+		exit(1);
+	}
+	linkRuntime();
+	optimize();
 
 	legacy::PassManager pm;
 	pm.add(createPrintModulePass(outs()));
 	pm.run(*module);
 }
 
+/* The runtime (native.cpp) as bitcode, embedded by runtime.cpp */
+extern "C" const char pascal_runtime_bitcode[], pascal_runtime_bitcode_end[];
+
+/* Links the runtime functions the program uses into the module and makes
+   everything but main internal, so the optimizer can inline and specialize
+   them like our own functions */
+void CodeGenContext::linkRuntime()
+{
+	StringRef bitcode(pascal_runtime_bitcode, pascal_runtime_bitcode_end - pascal_runtime_bitcode);
+	Expected<std::unique_ptr<Module> > runtime = parseBitcodeFile(MemoryBufferRef(bitcode, "runtime"), MyContext);
+	if (!runtime) {
+		std::cerr << "Error: can not read the runtime: " << toString(runtime.takeError()) << endl;
+		exit(1);
+	}
+	// 运行时按通用x86-64编译，去掉这些属性后才能内联进按本机CPU优化的函数
+	for (Function &function : **runtime) {
+		function.removeFnAttr("target-cpu");
+		function.removeFnAttr("target-features");
+		function.removeFnAttr("tune-cpu");
+	}
+	module->setDataLayout((*runtime)->getDataLayout());
+	module->setTargetTriple((*runtime)->getTargetTriple());
+	if (Linker::linkModules(*module, std::move(*runtime), Linker::Flags::LinkOnlyNeeded)) {
+		std::cerr << "Error: can not link the runtime" << endl;
+		exit(1);
+	}
+	internalizeModule(*module, [](const GlobalValue& value) { return value.getName() == "main"; });
+}
+
+/* Runs the standard -O2 pipeline for the host, so the loop passes
+   (IndVarSimplify, LoopVectorize, unrolling) see our canonical loops */
+void CodeGenContext::optimize()
+{
+	std::cout << "Optimizing code...\n";
+	TargetMachine *tm = EngineBuilder().setMCPU(sys::getHostCPUName()).selectTarget();
+	module->setDataLayout(tm->createDataLayout());
+	module->setTargetTriple(tm->getTargetTriple().str());
+
+	LoopAnalysisManager lam;
+	FunctionAnalysisManager fam;
+	CGSCCAnalysisManager cgam;
+	ModuleAnalysisManager mam;
+	PassBuilder pb(tm);
+	pb.registerModuleAnalyses(mam);
+	pb.registerCGSCCAnalyses(cgam);
+	pb.registerFunctionAnalyses(fam);
+	pb.registerLoopAnalyses(lam);
+	pb.crossRegisterProxies(lam, fam, cgam, mam);
+	ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(OptimizationLevel::O2);
+	mpm.run(*module, mam);
+	delete tm;
+}
+
 /* Executes the AST by running the main function */
 GenericValue CodeGenContext::runCode() {
 	std::cout << "Running code...\n";
-	ExecutionEngine *ee = EngineBuilder( unique_ptr<Module>(module) ).create();
+	ExecutionEngine *ee = EngineBuilder( unique_ptr<Module>(module) ).setMCPU(sys::getHostCPUName()).create();
 	ee->finalizeObject();
 	vector<GenericValue> noargs;
 	GenericValue v = ee->runFunction(mainFunction, noargs);
@@ -55,9 +143,162 @@ static Type *typeOf(const NIdentifier& type)
 		std::cout<<"isdouble"<<std::endl;
 		return Type::getDoubleTy(MyContext);
 	}
+	else if (type.name.compare("string") == 0) {
+		return StructType::getTypeByName(MyContext, "pascal.string");
+	}
+	else if (StructType *record = StructType::getTypeByName(MyContext, "record." + type.name)) {
+		return record;
+	}
 	return Type::getVoidTy(MyContext);
 }
 
+/* True for the string type, see corefn.cpp */
+static bool isString(Type *type)
+{
+	return type == StructType::getTypeByName(MyContext, "pascal.string");
+}
+
+/* String expressions evaluate to the address of a string: a variable, a
+   literal or a temporary */
+static bool isStringValue(Value *value)
+{
+	return value != NULL && value->getType()->isPointerTy() && isString(value->getType()->getPointerElementType());
+}
+
+/* Returns the type stored in a variable slot: an alloca, a global, a heap
+   array or a by-reference parameter */
+static Type *slotType(Value *slot)
+{
+	if (AllocaInst *alloca = dyn_cast<AllocaInst>(slot))
+		return alloca->getAllocatedType();
+	if (GlobalVariable *global = dyn_cast<GlobalVariable>(slot))
+		return global->getValueType();
+	return slot->getType()->getPointerElementType();
+}
+
+/* The value of a constant in scope, or NULL if name is not one */
+static Constant *namedConstant(CodeGenContext& context, const std::string& name)
+{
+	auto it = context.locals().find(name);
+	if (it == context.locals().end() || !(isa<ConstantInt>(it->second) || isa<ConstantFP>(it->second)))
+		return NULL;
+	return cast<Constant>(it->second);
+}
+
+/* Evaluates expr at compile time when it only involves literals, constants
+   and calls that evaluateCall can run; returns NULL otherwise. Operators
+   mean what NBinaryOperator makes of them at run time. */
+static Constant *foldConstant(CodeGenContext& context, NExpression& expr)
+{
+	if (NInteger *i = dyn_cast<NInteger>(&expr))
+		return ConstantInt::get(Type::getInt64Ty(MyContext), i->value, true);
+	if (NDouble *d = dyn_cast<NDouble>(&expr))
+		return ConstantFP::get(Type::getDoubleTy(MyContext), d->value);
+	if (NIdentifier *id = dyn_cast<NIdentifier>(&expr))
+		return namedConstant(context, id->name);
+	if (NMethodCall *call = dyn_cast<NMethodCall>(&expr)) {
+		Function *function = context.module->getFunction(call->id.name);
+		if (function == NULL || !context.constFunctions.count(function) || call->arguments.size() != function->arg_size())
+			return NULL;
+		std::vector<long long> args;
+		for (NExpression *arg : call->arguments) {
+			ConstantInt *value = dyn_cast_or_null<ConstantInt>(foldConstant(context, *arg));
+			if (value == NULL)
+				return NULL;
+			args.push_back(value->getSExtValue());
+		}
+		long long result;
+		if (!evaluateCall(context, function, args, result))
+			return NULL;
+		return ConstantInt::get(Type::getInt64Ty(MyContext), result, true);
+	}
+	NBinaryOperator *binop = dyn_cast<NBinaryOperator>(&expr);
+	if (binop == NULL)
+		return NULL;
+	ConstantInt *l = dyn_cast_or_null<ConstantInt>(foldConstant(context, binop->lhs));
+	ConstantInt *r = dyn_cast_or_null<ConstantInt>(foldConstant(context, binop->rhs));
+	if (l == NULL || r == NULL)
+		return NULL;
+	const APInt& a = l->getValue();
+	const APInt& b = r->getValue();
+	switch (binop->op) {
+		case TPLUS:		return ConstantInt::get(MyContext, a + b);
+		case TMINUS:	return ConstantInt::get(MyContext, a - b);
+		case TMUL:		return ConstantInt::get(MyContext, a * b);
+		case TDIV:
+			// 除零留到运行时，和普通表达式一样
+			if (b.isZero() || (a.isMinSignedValue() && b.isAllOnes()))
+				return NULL;
+			return ConstantInt::get(MyContext, a.sdiv(b));
+		case TCLT: case TCLE:	return ConstantInt::get(MyContext, b - a);
+		case TCGT: case TCGE:	return ConstantInt::get(MyContext, a - b);
+	}
+	return NULL;
+}
+
+/* Builds the row-major [R x [C x ... T]] type of an array declaration */
+static Type *arrayOf(CodeGenContext& context, Type *elementType, const ExpressionRange& dims, const std::string& name)
+{
+	Type* nested = elementType;
+	for (size_t i = dims.size(); i-- > 0; ) {
+		ConstantInt *dim = dyn_cast_or_null<ConstantInt>(foldConstant(context, *dims[i]));
+		if (dim == NULL || dim->isNegative()) {
+			std::cerr << "bounds of array " << name << " must be non-negative integer constants" << endl;
+			return NULL;
+		}
+		nested = ArrayType::get(nested, dim->getZExtValue());
+	}
+	return nested;
+}
+
+/* {i64 length, T* data}: what a dynamic array variable holds */
+static StructType *dynArrayType(Type *elementType)
+{
+	return StructType::get(MyContext, { Type::getInt64Ty(MyContext), elementType->getPointerTo() });
+}
+
+/* LLVM type of a parameter; array parameters are pointers to the caller's
+   array (or dynamic array descriptor) */
+static Type *paramType(CodeGenContext& context, NVariableDeclaration& param)
+{
+	NArrayParameter *array = dyn_cast<NArrayParameter>(&param);
+	if (array == NULL && isString(typeOf(param.type)))
+		return typeOf(param.type)->getPointerTo();
+	if (array == NULL)
+		return typeOf(param.type);
+	if (isString(typeOf(param.type))) {
+		std::cerr << "arrays of strings are not supported (parameter " << param.id.name << ")" << endl;
+		return NULL;
+	}
+	if (array->dims.empty())
+		return dynArrayType(typeOf(param.type))->getPointerTo();
+	Type *arrayType = arrayOf(context, typeOf(param.type), array->dims, param.id.name);
+	return arrayType == NULL ? NULL : arrayType->getPointerTo();
+}
+
+/* Allocas in the entry block are the ones mem2reg/SROA promote to registers */
+static AllocaInst *entryAlloca(Function *function, Type *type, const std::string& name)
+{
+	BasicBlock &entry = function->getEntryBlock();
+	IRBuilder<> builder(&entry, entry.getFirstInsertionPt());
+	return builder.CreateAlloca(type, 0, name);
+}
+
+/* An empty string slot in the entry block of the current function, freed
+   by releaseStorage; temporaries hold the results of string expressions */
+static Value *stringSlot(CodeGenContext& context, const std::string& name, bool temp)
+{
+	Function *function = context.currentBlock()->getParent();
+	Type *stringType = StructType::getTypeByName(MyContext, "pascal.string");
+	AllocaInst *slot = entryAlloca(function, stringType, name);
+	IRBuilder<> entryBuilder(slot->getParent(), ++slot->getIterator());
+	entryBuilder.CreateStore(ConstantAggregateZero::get(stringType), slot);
+	context.stringSlots[function].push_back(slot);
+	if (temp)
+		context.stringTemps.insert(slot);
+	return slot;
+}
+
 /* -- Code Generation -- */
 
 Value* NInteger::codeGen(CodeGenContext& context)
@@ -74,6 +315,27 @@ Value* NDouble::codeGen(CodeGenContext& context)
 	return ConstantFP::get(Type::getDoubleTy(MyContext), value);
 }
 
+Value* NString::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating string: " << value << endl;
+	// 字面量是只读的私有全局常量，字符串变量赋值时借用它的字符，不复制
+	StructType *stringType = StructType::getTypeByName(MyContext, "pascal.string");
+	Constant *chars = ConstantDataArray::getString(MyContext, value, false);
+	GlobalVariable *charsVar = new GlobalVariable(*context.module, chars->getType(), true, GlobalValue::PrivateLinkage, chars, ".str");
+	charsVar->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+	Constant *zero = ConstantInt::get(Type::getInt64Ty(MyContext), 0);
+	Constant *fields[] = {
+		ConstantExpr::getInBoundsGetElementPtr(chars->getType(), charsVar, makeArrayRef({ zero, zero })),
+		ConstantInt::get(Type::getInt64Ty(MyContext), value.size()),
+		zero,
+		ConstantAggregateZero::get(stringType->getElementType(3))
+	};
+	GlobalVariable *literal = new GlobalVariable(*context.module, stringType, true, GlobalValue::PrivateLinkage,
+		ConstantStruct::get(stringType, fields), ".string");
+	literal->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+	return literal;
+}
+
 Value* NIdentifier::codeGen(CodeGenContext& context)
 {
 	std::cout << "Creating identifier reference: " << name << endl;
@@ -83,30 +345,187 @@ Value* NIdentifier::codeGen(CodeGenContext& context)
 			return NULL;
 		}
 		else{
-			return new LoadInst(context.locals()[name+"__PASCAL__RET"]->getType(),context.locals()[name], "", false, context.currentBlock());
+			Value *slot = context.locals()[name+"__PASCAL__RET"];
+			if (isString(slotType(slot)))
+				return slot;
+			return new LoadInst(slotType(slot), slot, "", false, context.currentBlock());
 		}
 	}
+	else if (Constant *value = namedConstant(context, name)) {
+		// 常量直接作为立即数
+		return value;
+	}
 	else{
-		return new LoadInst(context.locals()[name]->getType(),context.locals()[name], name, false, context.currentBlock());
+		Value *slot = context.locals()[name];
+		// 字符串用地址表示，由使用它的运行时函数去读
+		if (isString(slotType(slot)))
+			return slot;
+		return new LoadInst(slotType(slot), slot, name, false, context.currentBlock());
+	}
+}
+
+static Value *dynArrayBuiltin(CodeGenContext& context, NMethodCall& call);
+static Value *readArrayBuiltin(CodeGenContext& context, NMethodCall& call);
+
+/* True if inst is in function and really touches memory; loads nobody
+   uses (views cached for a loop that never needs them) do not count */
+static bool accessIn(User *user, Function *function)
+{
+	Instruction *inst = dyn_cast<Instruction>(user);
+	return inst != NULL && inst->getFunction() == function && !(isa<LoadInst>(inst) && inst->use_empty());
+}
+
+/* True if function, or an internal function it calls, reads or writes
+   global directly */
+static bool usesGlobal(Function *function, GlobalVariable *global, std::set<Function*>& seen)
+{
+	if (!seen.insert(function).second)
+		return false;
+	for (User *user : global->users()) {
+		if (accessIn(user, function))
+			return true;
+		// 常量表达式（GEP）再往下找一层指令
+		if (isa<ConstantExpr>(user)) {
+			for (User *cuser : user->users()) {
+				if (accessIn(cuser, function))
+					return true;
+			}
+		}
+	}
+	for (BasicBlock& bb : *function) {
+		for (Instruction& inst : bb) {
+			CallInst *call = dyn_cast<CallInst>(&inst);
+			Function *callee = call != NULL ? call->getCalledFunction() : NULL;
+			if (callee != NULL && !callee->isDeclaration() && usesGlobal(callee, global, seen))
+				return true;
+		}
+	}
+	return false;
+}
+
+/* Argument for a by-reference array parameter: the address of the array
+   variable named by arg, which must have exactly the parameter's type */
+static Value *referenceArgument(CodeGenContext& context, NExpression& arg, Argument *param)
+{
+	NIdentifier *id = dyn_cast<NIdentifier>(&arg);
+	if (id == NULL || context.locals().find(id->name) == context.locals().end()) {
+		std::cerr << "argument " << param->getName().str() << " must be an array variable" << endl;
+		return NULL;
+	}
+	Value *slot = context.locals()[id->name];
+	if (slot->getType() != param->getType()) {
+		std::cerr << "array " << id->name << " does not match the type of parameter " << param->getName().str() << endl;
+		return NULL;
+	}
+	if (context.readOnlySlots.count(slot) && !param->onlyReadsMemory()) {
+		std::cerr << "const array " << id->name << " can not be passed as var parameter " << param->getName().str() << endl;
+		return NULL;
+	}
+	// 参数是noalias的，被调用的函数不能再通过全局名字访问同一个数组
+	std::set<Function*> seen;
+	if (isa<GlobalVariable>(slot) && usesGlobal(param->getParent(), cast<GlobalVariable>(slot), seen)) {
+		std::cerr << "global array " << id->name << " is passed to " << param->getParent()->getName().str() << ", which also uses it directly" << endl;
+		return NULL;
 	}
+	return slot;
 }
 
 Value* NMethodCall::codeGen(CodeGenContext& context)
 {
+	if (id.name == "setlength" || id.name == "length") {
+		return dynArrayBuiltin(context, *this);
+	}
+	if (id.name == "readarray") {
+		return readArrayBuiltin(context, *this);
+	}
+	if (id.name == "inttostr") {
+		Value *value = arguments.size() == 1 ? arguments[0]->codeGen(context) : NULL;
+		if (value == NULL || !value->getType()->isIntegerTy(64)) {
+			std::cerr << "inttostr expects an integer" << endl;
+			return NULL;
+		}
+		Value *temp = stringSlot(context, "inttostr", true);
+		CallInst::Create(context.module->getFunction("pascal_string_from_int"), { temp, value }, "", context.currentBlock());
+		return temp;
+	}
 	Function *function = context.module->getFunction(id.name.c_str());
 	if (function == NULL) {
 		std::cerr << "no such function " << id.name << endl;
+		return NULL;
+	}
+	// 参数都是常量、函数没有副作用时在编译时算出结果
+	if (Constant *value = foldConstant(context, *this)) {
+		std::cout << "Evaluated method call: " << id.name << endl;
+		return value;
 	}
 	std::vector<Value*> args;
-	ExpressionList::const_iterator it;
-	for (it = arguments.begin(); it != arguments.end(); it++) {
-		args.push_back((**it).codeGen(context));
+	for (size_t i = 0; i < arguments.size(); i++) {
+		bool stringParam = i < function->arg_size() && isStringValue(function->getArg(i));
+		if (i < function->arg_size() && function->getArg(i)->getType()->isPointerTy() && !stringParam)
+			args.push_back(referenceArgument(context, *arguments[i], function->getArg(i)));
+		else
+			args.push_back(arguments[i]->codeGen(context));
+		if (args.back() == NULL)
+			return NULL;
+		if (stringParam != isStringValue(args.back())) {
+			std::cerr << "argument " << function->getArg(i)->getName().str() << " of " << id.name << (stringParam ? " must" : " can not") << " be a string" << endl;
+			return NULL;
+		}
+	}
+	// 引用参数带noalias：同一个数组不能同时传给两个参数，除非都是const
+	for (size_t i = 0; i < args.size(); i++) {
+		for (size_t j = i + 1; j < args.size(); j++) {
+			if (args[i] == args[j] && args[i]->getType()->isPointerTy()
+					&& !(function->getArg(i)->onlyReadsMemory() && function->getArg(j)->onlyReadsMemory())) {
+				std::cerr << "array " << args[i]->getName().str() << " is passed to " << id.name << " twice" << endl;
+				return NULL;
+			}
+		}
 	}
 	CallInst *call = CallInst::Create(function, makeArrayRef(args), "", context.currentBlock());
+	call->setCallingConv(function->getCallingConv());
 	std::cout << "Creating method call: " << id.name << endl;
+	if (isString(call->getType())) {
+		// 返回的字符串放进临时槽，之前留在槽里的先释放
+		Value *temp = stringSlot(context, id.name + ".result", true);
+		CallInst::Create(context.module->getFunction("pascal_string_free"), temp, "", context.currentBlock());
+		new StoreInst(call, temp, false, context.currentBlock());
+		return temp;
+	}
 	return call;
 }
 
+/* a + b concatenates into a temporary; comparisons are 1 or 0 (true is
+   > 0), from the order pascal_string_compare gives */
+static Value *stringOperator(CodeGenContext& context, int op, Value *lhs, Value *rhs)
+{
+	if (!isStringValue(lhs) || !isStringValue(rhs)) {
+		std::cerr << "operands of a string operator must both be strings" << endl;
+		return NULL;
+	}
+	IRBuilder<> builder(context.currentBlock());
+	if (op == TPLUS) {
+		Value *temp = stringSlot(context, "concat", true);
+		builder.CreateCall(context.module->getFunction("pascal_string_concat"), { temp, lhs, rhs });
+		return temp;
+	}
+	Value *order = builder.CreateCall(context.module->getFunction("pascal_string_compare"), { lhs, rhs }, "order");
+	Value *zero = ConstantInt::get(order->getType(), 0);
+	Value *cond;
+	switch (op) {
+		case TCLT:	cond = builder.CreateICmpSLT(order, zero); break;
+		case TCLE:	cond = builder.CreateICmpSLE(order, zero); break;
+		case TCGT:	cond = builder.CreateICmpSGT(order, zero); break;
+		case TCGE:	cond = builder.CreateICmpSGE(order, zero); break;
+		case TCEQ:	cond = builder.CreateICmpEQ(order, zero); break;
+		case TCNE:	cond = builder.CreateICmpNE(order, zero); break;
+		default:
+			std::cerr << "operator " << op << " is not defined on strings" << endl;
+			return NULL;
+	}
+	return builder.CreateZExt(cond, order->getType());
+}
+
 Value* NBinaryOperator::codeGen(CodeGenContext& context)
 {
 	std::cout << "Creating binary operation " << op << endl;
@@ -122,44 +541,168 @@ Value* NBinaryOperator::codeGen(CodeGenContext& context)
 		case TCLE:		swap_pos=1;instr = Instruction::Sub; goto math;
 		case TCGT:		instr = Instruction::Sub; goto math;
 		case TCGE:		instr = Instruction::Sub; goto math;
+		case TCEQ: case TCNE:	instr = Instruction::Sub; goto math;
 	}
 	
 	return NULL;
 math:
+	if (Constant *value = foldConstant(context, *this))
+		return value;
+	// 操作数可能会切换当前块（例如数组越界检查），所以先求值再取currentBlock
+	Value *lhsValue = lhs.codeGen(context);
+	Value *rhsValue = rhs.codeGen(context);
+	if (lhsValue == NULL || rhsValue == NULL)
+		return NULL;
+	if (isStringValue(lhsValue) || isStringValue(rhsValue))
+		return stringOperator(context, op, lhsValue, rhsValue);
+	if (op == TCEQ || op == TCNE) {
+		// 相等比较的结果是1或0，也满足“大于0为真”
+		IRBuilder<> builder(context.currentBlock());
+		Value *cond = op == TCEQ ? builder.CreateICmpEQ(lhsValue, rhsValue) : builder.CreateICmpNE(lhsValue, rhsValue);
+		return builder.CreateZExt(cond, lhsValue->getType());
+	}
 	if (swap_pos==1){
-		return BinaryOperator::Create(instr, rhs.codeGen(context), 
-			lhs.codeGen(context), "", context.currentBlock());
+		return BinaryOperator::Create(instr, rhsValue, 
+			lhsValue, "", context.currentBlock());
 	}
 	else{
-		return BinaryOperator::Create(instr, lhs.codeGen(context), 
-		rhs.codeGen(context), "", context.currentBlock());
+		return BinaryOperator::Create(instr, lhsValue, 
+		rhsValue, "", context.currentBlock());
 	}
 
 }
 
+/* A self tail call can loop only if it passes every array parameter on
+   unchanged: those are bound to the caller's arrays, not to slots. String
+   parameters need a copy, so their functions keep recursing. */
+static bool reusesArrayParams(NMethodCall& call, TailLoop& loop)
+{
+	for (size_t i = 0; i < loop.params.size(); i++) {
+		// 字符串参数是复制进来的，不能直接存新值
+		if (!isa<Argument>(loop.params[i]) && isString(slotType(loop.params[i])))
+			return false;
+		if (!isa<Argument>(loop.params[i]))
+			continue;
+		NIdentifier *id = dyn_cast<NIdentifier>(call.arguments[i]);
+		if (id == NULL || id->name != loop.params[i]->getName())
+			return false;
+	}
+	return true;
+}
+
+/* f := f(args) in tail position: store the arguments into the parameter
+   slots and jump back to the top of the body instead of recursing */
+static Value *selfTailCall(CodeGenContext& context, NMethodCall& call, TailLoop& loop)
+{
+	std::cout << "Creating tail recursion loop for " << call.id.name << endl;
+	std::vector<Value*> args;
+	for (size_t i = 0; i < call.arguments.size(); i++) {
+		args.push_back(isa<Argument>(loop.params[i]) ? NULL : call.arguments[i]->codeGen(context));
+	}
+	for (size_t i = 0; i < args.size(); i++) {
+		if (args[i] != NULL)
+			new StoreInst(args[i], loop.params[i], false, context.currentBlock());
+	}
+	BranchInst *br = BranchInst::Create(loop.header, context.currentBlock());
+
+	// 跳转之后的代码不可达，放进一个新块里，外层的if仍然可以正常接上合并块
+	BasicBlock *contBB = BasicBlock::Create(MyContext, "tailcall.cont", loop.header->getParent());
+	std::map<std::string, Value*> templocals = context.locals();
+	std::map<std::string, Type*> temptps = context.tps();
+	std::map<std::string, ArrayType*> tempatps = context.atps();
+	context.popBlock();
+	context.pushBlock(contBB);
+	context.setTbs(templocals, temptps, tempatps);
+	return br;
+}
+
+/* name := rhs for a string slot. s := s + x appends in place, so a string
+   built piece by piece is copied only when its block grows; a temporary
+   is moved from, and anything else copied by the runtime, which shares
+   literals instead of copying them */
+static Value *assignString(CodeGenContext& context, Value *slot, const std::string& name, NExpression& rhs)
+{
+	NBinaryOperator *binop = dyn_cast<NBinaryOperator>(&rhs);
+	NIdentifier *self = binop != NULL && binop->op == TPLUS ? dyn_cast<NIdentifier>(&binop->lhs) : NULL;
+	const char *runtime = "pascal_string_assign";
+	Value *value;
+	if (self != NULL && self->name == name) {
+		runtime = "pascal_string_append";
+		value = binop->rhs.codeGen(context);
+	}
+	else {
+		value = rhs.codeGen(context);
+		if (context.stringTemps.count(value))
+			runtime = "pascal_string_move";
+	}
+	if (value == NULL)
+		return NULL;
+	if (!isStringValue(value)) {
+		std::cerr << "cannot assign a value that is not a string to string " << name << endl;
+		return NULL;
+	}
+	return CallInst::Create(context.module->getFunction(runtime), { slot, value }, "", context.currentBlock());
+}
+
 Value* NAssignment::codeGen(CodeGenContext& context)
 {
 	std::cout << "Creating assignment for " << lhs.name << endl;
+	if (std::find(context.forVariables.begin(), context.forVariables.end(), lhs.name) != context.forVariables.end()) {
+		std::cerr << "cannot assign to for loop variable " << lhs.name << endl;
+		return NULL;
+	}
+	if (context.locals().find(lhs.name) != context.locals().end() && context.readOnlySlots.count(context.locals()[lhs.name])) {
+		std::cerr << "cannot assign to const parameter " << lhs.name << endl;
+		return NULL;
+	}
+	if (namedConstant(context, lhs.name) != NULL) {
+		std::cerr << "cannot assign to constant " << lhs.name << endl;
+		return NULL;
+	}
+	auto target = context.locals().find(lhs.name);
+	if (target == context.locals().end())
+		target = context.locals().find(lhs.name + "__PASCAL__RET");
+	if (target != context.locals().end() && isString(slotType(target->second)))
+		return assignString(context, target->second, lhs.name, rhs);
+	if (context.tailCalls.count(this)) {
+		NMethodCall *call = (NMethodCall*)&rhs;
+		Function *function = context.currentBlock()->getParent();
+		auto loop = context.tailLoops.find(function);
+		if (loop != context.tailLoops.end() && context.module->getFunction(call->id.name) == function
+				&& call->arguments.size() == loop->second.params.size() && reusesArrayParams(*call, loop->second)) {
+			return selfTailCall(context, *call, loop->second);
+		}
+		// 调用其他函数：结果只是被返回，可以标记为tail（参数里有指针时被调用者可能访问本函数的栈，不能标）
+		Value *value = rhs.codeGen(context);
+		if (CallInst *inst = dyn_cast_or_null<CallInst>(value)) {
+			bool pointerArgs = false;
+			for (Value *arg : inst->args()) pointerArgs |= arg->getType()->isPointerTy();
+			if (!pointerArgs)
+				inst->setTailCall();
+		}
+		return new StoreInst(value, context.locals()[lhs.name+"__PASCAL__RET"], false, context.currentBlock());
+	}
 	if (context.locals().find(lhs.name) == context.locals().end()) {
 		if(context.locals().find(lhs.name+"__PASCAL__RET") ==context.locals().end()){
 			std::cerr << "undeclared variable " << lhs.name << endl;
 			return NULL;		
 		}
 		else{
-			return new StoreInst(rhs.codeGen(context), context.locals()[lhs.name+"__PASCAL__RET"], false, context.currentBlock());
+			Value *value = rhs.codeGen(context);
+			return new StoreInst(value, context.locals()[lhs.name+"__PASCAL__RET"], false, context.currentBlock());
 
 		}
 	}
 	else{
-		return new StoreInst(rhs.codeGen(context), context.locals()[lhs.name], false, context.currentBlock());
+		Value *value = rhs.codeGen(context);
+		return new StoreInst(value, context.locals()[lhs.name], false, context.currentBlock());
 	}
 }
 
 Value* NBlock::codeGen(CodeGenContext& context)
 {
-	StatementList::const_iterator it;
 	Value *last = NULL;
-	for (it = statements.begin(); it != statements.end(); it++) {
+	for (auto it = statements.begin(); it != statements.end(); it++) {
 		std::cout << "Generating code for " << typeid(**it).name() << endl;
 		last = (**it).codeGen(context);
 	}
@@ -177,6 +720,9 @@ Value* NReturnStatement::codeGen(CodeGenContext& context)
 {
 	std::cout << "Generating return code for " << typeid(expression).name() << endl;
 	Value *returnValue = expression.codeGen(context);
+	// 字符串结果按值返回，调用者接管它的字符
+	if (isStringValue(returnValue))
+		returnValue = new LoadInst(slotType(returnValue), returnValue, "", false, context.currentBlock());
 	context.setCurrentReturnValue(returnValue);
 	return returnValue;
 }
@@ -184,7 +730,28 @@ Value* NReturnStatement::codeGen(CodeGenContext& context)
 Value* NVariableDeclaration::codeGen(CodeGenContext& context)
 {
 	std::cout << "Creating variable declaration " << type.name << " " << id.name << endl;
-	AllocaInst *alloc = new AllocaInst(typeOf(type),4, id.name.c_str(), context.currentBlock());
+	Type *varType = typeOf(type);
+	Value *alloc;
+	bool result = id.name.size() > 13 && id.name.compare(id.name.size() - 13, 13, "__PASCAL__RET") == 0;
+	if (isString(varType) && !context.isTopLevel() && !result) {
+		// 和其它变量一样，循环里再次执行到声明时保留原来的值
+		alloc = stringSlot(context, id.name, false);
+	}
+	else if (context.isTopLevel()) {
+		// 顶层变量是模块的全局变量，所有函数都能看到；只在main里用的由GlobalOpt再变回局部
+		alloc = new GlobalVariable(*context.module, varType, false, GlobalValue::InternalLinkage, Constant::getNullValue(varType), id.name);
+		if (isString(varType))
+			context.stringSlots[context.currentBlock()->getParent()].push_back(alloc);
+	}
+	else {
+		// 槽总在入口块里分配，循环（包括尾递归变成的循环）里的声明不会每次都增长栈
+		alloc = entryAlloca(context.currentBlock()->getParent(), varType, id.name);
+		// 字符串结果从零开始，返回时交给调用者，不在这里释放
+		if (isString(varType)) {
+			IRBuilder<> entryBuilder(cast<Instruction>(alloc)->getParent(), ++cast<Instruction>(alloc)->getIterator());
+			entryBuilder.CreateStore(ConstantAggregateZero::get(varType), alloc);
+		}
+	}
 	context.locals()[id.name] = alloc;
 	if (assignmentExpr != NULL) {
 		NAssignment assn(id, *assignmentExpr);
@@ -204,58 +771,425 @@ Value* NVariableDeclarationS::codeGen(CodeGenContext& context)
 
 }
 
+Value* NConstDeclaration::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating constant " << id.name << endl;
+	Constant *constant = foldConstant(context, value);
+	if (constant == NULL) {
+		std::cerr << "value of constant " << id.name << " is not known at compile time" << endl;
+		return NULL;
+	}
+	// 常量和变量在同一张表里，引用它的地方直接得到立即数
+	context.locals()[id.name] = constant;
+	return constant;
+}
+
 Value* NExternDeclaration::codeGen(CodeGenContext& context)
 {
     vector<Type*> argTypes;
     VariableList::const_iterator it;
     for (it = arguments.begin(); it != arguments.end(); it++) {
-        argTypes.push_back(typeOf((**it).type));
+        argTypes.push_back(paramType(context, **it));
     }
     FunctionType *ftype = FunctionType::get(typeOf(type), makeArrayRef(argTypes), false);
+    // printi、flush等运行时函数已经声明过了，类型一致时直接用
+    if (Function *existing = context.module->getFunction(id.name)) {
+        if (existing->getFunctionType() == ftype)
+            return existing;
+    }
     Function *function = Function::Create(ftype, GlobalValue::ExternalLinkage, id.name.c_str(), context.module);
+    // 外部函数都是C写的运行时，不会抛出异常穿过我们的栈帧
+    function->addFnAttr(Attribute::NoUnwind);
     return function;
 }
 
+/* Maps the directives written after a function's return type to attributes */
+static void addFunctionDirectives(Function *function, const std::vector<std::string>& directives)
+{
+	for (auto& directive : directives) {
+		if (directive == "inline") {
+			function->addFnAttr(Attribute::AlwaysInline);
+		}
+		else if (directive == "noinline") {
+			function->addFnAttr(Attribute::NoInline);
+		}
+		else if (directive == "pure") {
+			// 有数组参数的纯函数只读它们指向的内存
+			bool arrayArgs = false;
+			for (Argument &arg : function->args()) arrayArgs |= arg.getType()->isPointerTy();
+			if (arrayArgs) {
+				function->addFnAttr(Attribute::ReadOnly);
+				function->addFnAttr(Attribute::ArgMemOnly);
+			}
+			else {
+				function->addFnAttr(Attribute::ReadNone);
+			}
+			function->addFnAttr(Attribute::WillReturn);
+			function->addFnAttr(Attribute::NoUnwind);
+		}
+		else if (directive == "hot") {
+			function->addFnAttr(Attribute::Hot);
+		}
+		else if (directive == "cold") {
+			function->addFnAttr(Attribute::Cold);
+		}
+		else if (directive == "memo") {
+			// 查表代码由NFunctionDeclaration生成
+		}
+		else {
+			std::cerr << "unknown function directive " << directive << " on " << function->getName().str() << endl;
+		}
+	}
+	if (function->hasFnAttribute(Attribute::AlwaysInline) && function->hasFnAttribute(Attribute::NoInline)) {
+		std::cerr << "function " << function->getName().str() << " is both inline and noinline, ignoring inline" << endl;
+		function->removeFnAttr(Attribute::AlwaysInline);
+	}
+	if (function->hasFnAttribute(Attribute::Hot) && function->hasFnAttribute(Attribute::Cold)) {
+		std::cerr << "function " << function->getName().str() << " is both hot and cold, ignoring hot" << endl;
+		function->removeFnAttr(Attribute::Hot);
+	}
+}
+
+/* A pure function may only touch its own stack slots, read its array
+   parameters and call other pure functions (memo functions count, as do
+   its own recursive calls); anything else would make readnone/readonly a
+   lie the optimizer acts on, or memo return stale results */
+static bool checkPure(CodeGenContext& context, Function *function, const std::string& directive)
+{
+	for (BasicBlock &bb : *function) {
+		for (Instruction &inst : bb) {
+			Value *ptr = NULL;
+			if (LoadInst *load = dyn_cast<LoadInst>(&inst)) ptr = load->getPointerOperand();
+			if (StoreInst *store = dyn_cast<StoreInst>(&inst)) ptr = store->getPointerOperand();
+			Value *object = ptr == NULL ? NULL : getUnderlyingObject(ptr);
+			// 动态数组参数的数据指针是从描述符里读出来的
+			if (LoadInst *load = dyn_cast_or_null<LoadInst>(object))
+				object = getUnderlyingObject(load->getPointerOperand());
+			if (ptr != NULL && !isa<AllocaInst>(object) && !(isa<Argument>(object) && isa<LoadInst>(inst))) {
+				std::cerr << "warning: " << directive << " function " << function->getName().str() << " accesses memory outside its frame" << endl;
+				return false;
+			}
+			CallInst *call = dyn_cast<CallInst>(&inst);
+			Function *callee = call == NULL ? NULL : call->getCalledFunction();
+			if (callee == NULL || callee == function || context.memoFunctions.count(callee) || callee->getName().startswith("pascal_memo_"))
+				continue;
+			if (!callee->isIntrinsic() && !callee->doesNotAccessMemory()
+					&& !(callee->onlyReadsMemory() && callee->onlyAccessesArgMemory())) {
+				std::cerr << "warning: " << directive << " function " << function->getName().str() << " calls " << callee->getName().str() << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* Takes back the attributes of the pure directive from a function that
+   failed checkPure, so its callers are optimized as for any other call */
+static void dropPure(Function *function)
+{
+	function->removeFnAttr(Attribute::ReadNone);
+	function->removeFnAttr(Attribute::ReadOnly);
+	function->removeFnAttr(Attribute::ArgMemOnly);
+	function->removeFnAttr(Attribute::WillReturn);
+}
+
+/* Entry lookup of a memo function: the arguments are the key into a
+   runtime hash table (see native.cpp), and a hit goes straight to the
+   exit block with the stored result */
+class MemoLookup {
+public:
+	GlobalVariable *table;
+	Value *key;
+	CallInst *lookup;
+	CallInst *store;
+	Instruction *found;
+	BasicBlock *hit;
+	Value *hitValue;
+	BasicBlock *exit;
+};
+
+/* memo needs what the table can key on and hold: integers */
+static bool memoizable(NFunctionDeclaration& decl)
+{
+	bool ints = decl.type.name == "int";
+	for (NVariableDeclaration *arg : decl.arguments) {
+		ints &= !isa<NArrayParameter>(arg) && arg->type.name == "int";
+	}
+	if (!ints)
+		std::cerr << "warning: memo function " << decl.id.name << " needs integer parameters and an integer result, not memoizing" << endl;
+	return ints;
+}
+
+static void emitMemoLookup(CodeGenContext& context, Function *function, MemoLookup& memo)
+{
+	Type *int64Ty = Type::getInt64Ty(MyContext);
+	Type *tableType = Type::getInt8PtrTy(MyContext);
+	size_t nargs = function->arg_size();
+	memo.table = new GlobalVariable(*context.module, tableType, false, GlobalValue::InternalLinkage,
+			ConstantPointerNull::get(cast<PointerType>(tableType)), function->getName() + ".memo");
+	ArrayType *keyType = ArrayType::get(int64Ty, std::max<size_t>(nargs, 1));
+	Value *keySlot = entryAlloca(function, keyType, "memo.key");
+	Value *valueSlot = entryAlloca(function, int64Ty, "memo.value");
+
+	IRBuilder<> builder(context.currentBlock());
+	memo.key = builder.CreateConstInBoundsGEP2_64(keyType, keySlot, 0, 0);
+	for (Argument& arg : function->args()) {
+		builder.CreateStore(&arg, builder.CreateConstInBoundsGEP1_64(int64Ty, memo.key, arg.getArgNo()));
+	}
+	memo.lookup = builder.CreateCall(context.module->getFunction("pascal_memo_lookup"),
+			{ memo.table, builder.getInt64(nargs), memo.key, valueSlot });
+	memo.found = cast<Instruction>(builder.CreateICmpNE(memo.lookup, builder.getInt64(0), "memo.found"));
+	memo.hit = BasicBlock::Create(MyContext, "memo.hit", function);
+	BasicBlock *miss = BasicBlock::Create(MyContext, "memo.miss", function);
+	memo.exit = BasicBlock::Create(MyContext, "memo.exit");
+	builder.CreateCondBr(memo.found, memo.hit, miss);
+
+	IRBuilder<> hitBuilder(memo.hit);
+	memo.hitValue = hitBuilder.CreateLoad(int64Ty, valueSlot, "memo.cached");
+	hitBuilder.CreateBr(memo.exit);
+
+	std::map<std::string, Value*> templocals = context.locals();
+	std::map<std::string, Type*> temptps = context.tps();
+	std::map<std::string, ArrayType*> tempatps = context.atps();
+	context.popBlock();
+	context.pushBlock(miss);
+	context.setTbs(templocals, temptps, tempatps);
+}
+
+/* Records result for the key and joins the hit path in the exit block;
+   returns the value the function returns */
+static Value *emitMemoReturn(CodeGenContext& context, Function *function, MemoLookup& memo, Value *result)
+{
+	IRBuilder<> builder(context.currentBlock());
+	memo.store = builder.CreateCall(context.module->getFunction("pascal_memo_store"),
+			{ memo.table, builder.getInt64(function->arg_size()), memo.key, result });
+	builder.CreateBr(memo.exit);
+	BasicBlock *body = context.currentBlock();
+
+	memo.exit->insertInto(function);
+	std::map<std::string, Value*> templocals = context.locals();
+	std::map<std::string, Type*> temptps = context.tps();
+	std::map<std::string, ArrayType*> tempatps = context.atps();
+	context.popBlock();
+	context.pushBlock(memo.exit);
+	context.setTbs(templocals, temptps, tempatps);
+	PHINode *phi = PHINode::Create(result->getType(), 2, "memo.result", memo.exit);
+	phi->addIncoming(memo.hitValue, memo.hit);
+	phi->addIncoming(result, body);
+	return phi;
+}
+
+/* Turns the lookup into a miss that is never recorded, for memo functions
+   that turned out not to be pure */
+static void dropMemo(MemoLookup& memo)
+{
+	memo.found->replaceAllUsesWith(ConstantInt::getFalse(MyContext));
+	memo.found->eraseFromParent();
+	memo.lookup->eraseFromParent();
+	memo.store->eraseFromParent();
+}
+
+/* Collects the assignments fname := call(...) that are the last action of
+   a function body, looking through trailing blocks and both if branches */
+static void findTailCalls(Node *node, const std::string& fname, std::vector<NAssignment*>& calls)
+{
+	switch (node->kind) {
+		case NODE_BLOCK: {
+			NBlock *block = cast<NBlock>(node);
+			if (!block->statements.empty())
+				findTailCalls(block->statements.back(), fname, calls);
+			break;
+		}
+		case NODE_EXPRESSION_STATEMENT:
+			findTailCalls(&cast<NExpressionStatement>(node)->expression, fname, calls);
+			break;
+		case NODE_IF: {
+			NIFStatement *stmt = cast<NIFStatement>(node);
+			findTailCalls(&stmt->ifStatement, fname, calls);
+			if (&stmt->elseStatement != &stmt->ifStatement)
+				findTailCalls(&stmt->elseStatement, fname, calls);
+			break;
+		}
+		case NODE_ASSIGNMENT: {
+			NAssignment *assn = cast<NAssignment>(node);
+			if (assn->lhs.name == fname && isa<NMethodCall>(&assn->rhs))
+				calls.push_back(assn);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/* Array parameters are used in place: the argument pointer itself is the
+   array's slot. Distinct arrays are enforced at call sites, so the pointer
+   is noalias; const ones are readonly. */
+static void bindArrayParameter(CodeGenContext& context, NArrayParameter& param, Argument *arg)
+{
+	Type *pointee = slotType(arg);
+	const std::string& name = param.id.name;
+	context.locals()[name] = arg;
+	context.tps()[name] = typeOf(param.type);
+	if (param.dims.empty()) {
+		context.dynArrays.insert(arg);
+	}
+	else {
+		context.atps()[name] = cast<ArrayType>(pointee);
+	}
+	arg->addAttr(Attribute::NoAlias);
+	arg->addAttr(Attribute::getWithDereferenceableBytes(MyContext, context.module->getDataLayout().getTypeAllocSize(pointee)));
+	if (param.mode == PARAM_CONST) {
+		arg->addAttr(Attribute::ReadOnly);
+		context.readOnlySlots.insert(arg);
+	}
+}
+
 Value* NFunctionDeclaration::codeGen(CodeGenContext& context)
 {
+	// 在加入返回语句之前找出尾位置上的调用
+	std::vector<NAssignment*> tails;
+	findTailCalls(&block, id.name, tails);
+
 	vector<Type*> argTypes;
 	VariableList::const_iterator it;
 	for (it = arguments.begin(); it != arguments.end(); it++) {
-		argTypes.push_back(typeOf((**it).type));
+		Type *argType = paramType(context, **it);
+		if (argType == NULL)
+			return NULL;
+		argTypes.push_back(argType);
 	}
 	FunctionType *ftype = FunctionType::get(typeOf(type), makeArrayRef(argTypes), false);
 	Function *function = Function::Create(ftype, GlobalValue::InternalLinkage, id.name.c_str(), context.module);
+	// 内部函数的所有调用点都由我们生成，可以用fastcc
+	function->setCallingConv(CallingConv::Fast);
+	addFunctionDirectives(function, directives);
 	BasicBlock *bblock = BasicBlock::Create(MyContext, "entry", function, 0);
 	for (auto k: context.locals()) {
 		cout<<"kkk:"<<k.first<<endl;
 	}
 	BasicBlock* topBlock = context.currentBlock();
+	// 函数体看得到在它之前声明的全局变量、数组和常量，看不到main里的其它东西
+	std::map<std::string, Value*> globals;
+	std::map<std::string, Type*> globaltps;
+	std::map<std::string, ArrayType*> globalatps;
+	for (auto& local : context.locals()) {
+		if (!isa<GlobalVariable>(local.second) && namedConstant(context, local.first) == NULL)
+			continue;
+		globals[local.first] = local.second;
+		if (context.tps().count(local.first))
+			globaltps[local.first] = context.tps()[local.first];
+		if (context.atps().count(local.first))
+			globalatps[local.first] = context.atps()[local.first];
+	}
 	context.pushBlock(bblock);
+	context.setTbs(globals, globaltps, globalatps);
 	
 
 	Function::arg_iterator argsValues = function->arg_begin();
     Value* argumentValue;
 
 	for (it = arguments.begin(); it != arguments.end(); it++) {
-		(**it).codeGen(context);
-		
 		argumentValue = &*argsValues++;
 		argumentValue->setName((*it)->id.name.c_str());
+		if (NArrayParameter *array = dyn_cast<NArrayParameter>(*it)) {
+			bindArrayParameter(context, *array, cast<Argument>(argumentValue));
+			continue;
+		}
+		if (isStringValue(argumentValue)) {
+			// const字符串直接用调用者的，其它的复制一份，函数里改了不影响调用者
+			Argument *arg = cast<Argument>(argumentValue);
+			arg->addAttr(Attribute::ReadOnly);
+			arg->addAttr(Attribute::NoCapture);
+			if ((*it)->mode == PARAM_CONST) {
+				context.locals()[(*it)->id.name] = arg;
+				context.readOnlySlots.insert(arg);
+				continue;
+			}
+			(**it).codeGen(context);
+			CallInst::Create(context.module->getFunction("pascal_string_assign"), { context.locals()[(*it)->id.name], arg }, "", bblock);
+			continue;
+		}
+		(**it).codeGen(context);
 		StoreInst *inst = new StoreInst(argumentValue, context.locals()[(*it)->id.name], false, bblock);
+		if ((*it)->mode == PARAM_CONST)
+			context.readOnlySlots.insert(context.locals()[(*it)->id.name]);
 	}
 
 	//中间构造返回值
 	
 	NIdentifier* ret_ident=new NIdentifier(id.name + "__PASCAL__RET");
-	block.statements.push_back( new NReturnStatement(*ret_ident)); //返回操作加入到block中
+	NReturnStatement *ret_stmt = new NReturnStatement(*ret_ident); //函数体生成完后生成返回操作
 
 	NVariableDeclaration *ret_define=new NVariableDeclaration( type, *ret_ident   );
 	ret_define->codeGen(context);
 
 	//返回值构造结束
 
+	// memo：入口先用参数查表，命中就直接返回；函数体算完后把结果记进表里
+	MemoLookup memo;
+	bool memoized = std::find(directives.begin(), directives.end(), "memo") != directives.end() && memoizable(*this);
+	if (memoized)
+		emitMemoLookup(context, function, memo);
+
+	// 直接自递归的尾调用变成循环：入口块之后是循环头，尾调用写参数后跳回这里
+	bool selfTail = false;
+	for (NAssignment *tail : tails) {
+		context.tailCalls.insert(tail);
+		NMethodCall *call = (NMethodCall*)&tail->rhs;
+		selfTail |= call->id.name == id.name && call->arguments.size() == arguments.size();
+	}
+	if (selfTail) {
+		TailLoop& loop = context.tailLoops[function];
+		for (it = arguments.begin(); it != arguments.end(); it++) {
+			loop.params.push_back(context.locals()[(*it)->id.name]);
+		}
+		loop.header = BasicBlock::Create(MyContext, "tailrecurse", function);
+		BranchInst::Create(loop.header, context.currentBlock());
+		std::map<std::string, Value*> templocals = context.locals();
+		std::map<std::string, Type*> temptps = context.tps();
+		std::map<std::string, ArrayType*> tempatps = context.atps();
+		context.popBlock();
+		context.pushBlock(loop.header);
+		context.setTbs(templocals, temptps, tempatps);
+	}
+
 	block.codeGen(context);
-	ReturnInst::Create(MyContext, context.getCurrentReturnValue(), context.currentBlock());
+	ret_stmt->codeGen(context);
+	for (NAssignment *tail : tails) {
+		context.tailCalls.erase(tail);
+	}
+	context.tailLoops.erase(function);
+	Value *result = context.getCurrentReturnValue();
+	if (memoized)
+		result = emitMemoReturn(context, function, memo, result);
+	context.releaseStorage(function);
+	ReturnInst::Create(MyContext, result, context.currentBlock());
+	if (std::find(directives.begin(), directives.end(), "pure") != directives.end() && !checkPure(context, function, "pure")) {
+		std::cerr << "warning: function " << id.name << " is not treated as pure" << endl;
+		dropPure(function);
+	}
+	if (memoized && !checkPure(context, function, "memo")) {
+		std::cerr << "warning: function " << id.name << " is not memoized" << endl;
+		dropMemo(memo);
+	}
+	else if (memoized) {
+		context.memoFunctions.insert(function);
+	}
+	// 整数参数、整数结果的函数可以在编译时对常量参数求值
+	bool evaluable = type.name == "int";
+	for (NVariableDeclaration *arg : arguments) {
+		evaluable &= !isa<NArrayParameter>(arg) && arg->type.name == "int";
+	}
+	if (evaluable) {
+		ConstFunction constFunction;
+		constFunction.decl = this;
+		for (auto& global : globals) {
+			constFunction.scope[global.first] = isa<GlobalVariable>(global.second) ? NULL : cast<Constant>(global.second);
+		}
+		// 写全局变量、调用运行时函数、用数组的函数求值一定失败，不用留着语法树
+		if (mayEvaluate(context, constFunction))
+			context.constFunctions[function] = constFunction;
+	}
 	while(topBlock != context.currentBlock()){
 		context.popBlock();
 	}
@@ -280,7 +1214,7 @@ llvm::Value* NIFStatement::codeGen(CodeGenContext& context)
     llvm::BasicBlock* mergeBlock = llvm::BasicBlock::Create(MyContext, "ifcont", function);
 	std::cout<<"1111"<<std::endl;
     // 如果条件为true，则跳转到then块；否则跳转到else块
-	llvm::Value* zero = llvm::ConstantInt::get(MyContext, llvm::APInt(32, 0));
+	llvm::Value* zero = llvm::ConstantInt::get(condValue->getType(), 0);
 	llvm::Value* cmp = llvm::CmpInst::Create(llvm::Instruction::ICmp, llvm::CmpInst::ICMP_SGT, condValue, zero, "ifcond", context.currentBlock());
 	BranchInst::Create(thenBlock, elseBlock, cmp, context.currentBlock());	
 	std::map<std::string, Value*> templocals,templocals_1,templocals_2;
@@ -325,175 +1259,1185 @@ llvm::Value* NIFStatement::codeGen(CodeGenContext& context)
 	return condValue;
 }
 
+/* Builds the constant for an array initializer: values are taken in
+   row-major order from next, missing trailing elements are zero */
+static Constant *initializerOf(CodeGenContext& context, Type *type, const ExpressionRange& values, size_t& next, const std::string& name)
+{
+	if (ArrayType *arrayType = dyn_cast<ArrayType>(type)) {
+		std::vector<Constant*> elements;
+		for (uint64_t i = 0; i < arrayType->getNumElements(); i++) {
+			Constant *element = initializerOf(context, arrayType->getElementType(), values, next, name);
+			if (element == NULL)
+				return NULL;
+			elements.push_back(element);
+		}
+		return ConstantArray::get(arrayType, elements);
+	}
+	if (next >= values.size())
+		return Constant::getNullValue(type);
+	Constant *value = foldConstant(context, *values[next++]);
+	if (value == NULL) {
+		std::cerr << "initializer of " << name << " must be made of constants" << endl;
+		return NULL;
+	}
+	// 整数可以初始化double数组，反过来不行
+	if (ConstantInt *i = dyn_cast<ConstantInt>(value)) {
+		if (type->isDoubleTy())
+			return ConstantFP::get(type, (double)i->getSExtValue());
+	}
+	if (value->getType() != type) {
+		std::cerr << "initializer of " << name << " does not match its element type" << endl;
+		return NULL;
+	}
+	return value;
+}
+
+/* Local arrays bigger than this live on the heap instead of the stack */
+static const uint64_t MaxStackArrayBytes = 64 * 1024;
+
+/* var a: array of T -- the slot holds a {length, data} descriptor that
+   starts out empty */
+static Value *dynArrayDeclaration(CodeGenContext& context, NArrayDeclaration& decl)
+{
+	std::cout << "Creating dynamic array declaration " << decl.type.name << " " << decl.id.name << endl;
+	for (auto& pragma : decl.pragmas) {
+		std::cerr << "ignoring " << pragma << " on dynamic array " << decl.id.name << endl;
+	}
+	Type* elementType = typeOf(decl.type);
+	StructType *descType = dynArrayType(elementType);
+	Value *desc;
+	if (context.isTopLevel()) {
+		desc = new GlobalVariable(*context.module, descType, false, GlobalValue::InternalLinkage, ConstantAggregateZero::get(descType), decl.id.name);
+	}
+	else {
+		// 描述符放在入口块，声明处清零（长度0，数据指针为空）
+		desc = entryAlloca(context.currentBlock()->getParent(), descType, decl.id.name);
+		new StoreInst(ConstantAggregateZero::get(descType), desc, false, context.currentBlock());
+	}
+	context.locals()[decl.id.name] = desc;
+	context.tps()[decl.id.name] = elementType;
+	context.dynArrays.insert(desc);
+	return desc;
+}
+
+/* var a: file array[N] of T = 'path' -- maps the file and exposes it through
+   a dynamic array descriptor, with N elements or, without a bound, as many
+   as the file holds. Writes go to private copy-on-write pages unless the
+   array is {$readonly}; {$sequential}, {$random} and {$willneed} are passed
+   to madvise. */
+static Value *fileArrayDeclaration(CodeGenContext& context, NArrayDeclaration& decl)
+{
+	std::cout << "Creating file array declaration " << decl.type.name << " " << decl.id.name << " = '" << decl.file << "'" << endl;
+	Type* elementType = typeOf(decl.type);
+	if (elementType->isVoidTy()) {
+		std::cerr << "unknown type " << decl.type.name << " for file array " << decl.id.name << endl;
+		return NULL;
+	}
+	if (decl.dims.size() > 1) {
+		std::cerr << "file array " << decl.id.name << " takes one dimension" << endl;
+		return NULL;
+	}
+	long long elements = -1;
+	if (!decl.dims.empty()) {
+		Type *arrayType = arrayOf(context, elementType, decl.dims, decl.id.name);
+		if (arrayType == NULL)
+			return NULL;
+		elements = arrayType->getArrayNumElements();
+	}
+	bool readOnly = false;
+	int advice = MADV_NORMAL;
+	for (auto& pragma : decl.pragmas) {
+		std::istringstream words(pragma.substr(2, pragma.size() - 3));
+		std::string name;
+		words >> name;
+		if (name == "readonly")
+			readOnly = true;
+		else if (name == "sequential")
+			advice = MADV_SEQUENTIAL;
+		else if (name == "random")
+			advice = MADV_RANDOM;
+		else if (name == "willneed")
+			advice = MADV_WILLNEED;
+		else
+			std::cerr << "unknown array directive " << pragma << endl;
+	}
+
+	StructType *descType = dynArrayType(elementType);
+	Function *function = context.currentBlock()->getParent();
+	Value *desc;
+	if (context.isTopLevel()) {
+		desc = new GlobalVariable(*context.module, descType, false, GlobalValue::InternalLinkage, ConstantAggregateZero::get(descType), decl.id.name);
+	}
+	else {
+		// 描述符在入口块清零，没有执行到声明就返回时也能安全地解除映射
+		AllocaInst *alloca = entryAlloca(function, descType, decl.id.name);
+		IRBuilder<> entryBuilder(alloca->getParent(), ++alloca->getIterator());
+		entryBuilder.CreateStore(ConstantAggregateZero::get(descType), alloca);
+		context.mappedArrays[function].push_back(alloca);
+		desc = alloca;
+	}
+	// 运行时把映射的长度和地址写进描述符，再次执行声明时先解除上一次的映射
+	IRBuilder<> builder(context.currentBlock());
+	Type *int64Ty = builder.getInt64Ty();
+	Value *path = builder.CreateGlobalStringPtr(decl.file, decl.id.name + ".path");
+	Value *elementBytes = ConstantInt::get(int64Ty, context.module->getDataLayout().getTypeAllocSize(elementType));
+	builder.CreateCall(context.module->getFunction("pascal_map_file"), { builder.CreateBitCast(desc, builder.getInt8PtrTy()), path, elementBytes,
+		ConstantInt::get(int64Ty, elements), ConstantInt::get(int64Ty, readOnly), ConstantInt::get(int64Ty, advice) });
+
+	context.locals()[decl.id.name] = desc;
+	context.tps()[decl.id.name] = elementType;
+	context.dynArrays.insert(desc);
+	context.fileArrays.insert(desc);
+	if (readOnly)
+		context.readOnlySlots.insert(desc);
+	return desc;
+}
+
 Value* NArrayDeclaration::codeGen(CodeGenContext& context)
 {
+	if (isString(typeOf(type))) {
+		std::cerr << "arrays of strings are not supported (array " << id.name << ")" << endl;
+		return NULL;
+	}
+	if (!file.empty())
+		return fileArrayDeclaration(context, *this);
+	if (dims.empty())
+		return dynArrayDeclaration(context, *this);
 	std::cout << "Creating Array declaration " << type.name << " " << id.name << endl;
 	Type* elementType = typeOf(type);
-	ArrayType *arrayType = ArrayType::get(elementType, sz.value);
-	// GlobalVariable* globalArray = new GlobalVariable(*context.module, arrayType, false, GlobalValue::ExternalLinkage, nullptr, id.name);
-	AllocaInst* array = new AllocaInst(arrayType,4, id.name.c_str(), context.currentBlock());
+	// array[R, C] of T 按行存储为 [R x [C x T]]，GEP时每一维一个下标
+	Type* nested = arrayOf(context, elementType, dims, id.name);
+	if (nested == NULL)
+		return NULL;
+	ArrayType *arrayType = cast<ArrayType>(nested);
+
+	// {$soa}: 记录数组按字段拆成 { [N x f1], [N x f2], ... }，只访问一个字段的循环连续读写
+	Type *storageType = arrayType;
+	bool soa = false;
+	for (auto& pragma : pragmas) {
+		std::istringstream words(pragma.substr(2, pragma.size() - 3));
+		std::string name;
+		words >> name;
+		if (name == "soa" && context.recordFields.count(dyn_cast<StructType>(elementType))) {
+			soa = true;
+		}
+		else if (name == "soa") {
+			std::cerr << "ignoring " << pragma << ": " << id.name << " is not an array of records" << endl;
+		}
+		else {
+			std::cerr << "unknown array directive " << pragma << endl;
+		}
+	}
+	if (soa) {
+		std::vector<Type*> fieldArrays;
+		for (Type *fieldType : cast<StructType>(elementType)->elements()) {
+			fieldArrays.push_back(arrayOf(context, fieldType, dims, id.name));
+		}
+		storageType = StructType::get(MyContext, fieldArrays);
+	}
+
+	Constant *init = NULL;
+	if (!initializer.empty()) {
+		if (soa || !elementType->isSingleValueType()) {
+			std::cerr << "array " << id.name << " of records can not have an initializer" << endl;
+			return NULL;
+		}
+		size_t next = 0;
+		init = initializerOf(context, arrayType, initializer, next, id.name);
+		if (init == NULL)
+			return NULL;
+		if (next < initializer.size()) {
+			std::cerr << "too many values in the initializer of " << id.name << endl;
+			return NULL;
+		}
+	}
+
+	const DataLayout& layout = context.module->getDataLayout();
+	uint64_t bytes = layout.getTypeAllocSize(storageType);
+	Value* array;
+	if (context.isTopLevel()) {
+		// 顶层数组放在全局区：初值直接写在全局变量里，零初始化的进.bss，都不需要代码
+		if (init == NULL)
+			init = ConstantAggregateZero::get(storageType);
+		array = new GlobalVariable(*context.module, storageType, false, GlobalValue::InternalLinkage, init, id.name);
+	}
+	else if (bytes > MaxStackArrayBytes) {
+		// 函数里的大数组在入口块从堆上分配，函数返回前释放
+		Function *function = context.currentBlock()->getParent();
+		Instruction *insertPt = &*function->getEntryBlock().getFirstInsertionPt();
+		Value *size = ConstantInt::get(Type::getInt64Ty(MyContext), bytes);
+		Value *mem = CallInst::Create(context.module->getFunction("pascal_alloc"), size, id.name + ".heap", insertPt);
+		array = new BitCastInst(mem, storageType->getPointerTo(), id.name, insertPt);
+		context.heapArrays[function].push_back(array);
+	}
+	else {
+		array = entryAlloca(context.currentBlock()->getParent(), storageType, id.name);
+	}
+
+	if (!context.isTopLevel()) {
+		// 局部数组在声明处整体初始化：初值表是只读的常量，一次memcpy；没有初值时memset清零
+		IRBuilder<> builder(context.currentBlock());
+		Align align = layout.getPrefTypeAlign(storageType);
+		Function *function = context.currentBlock()->getParent();
+		bool zeroed = bytes > MaxStackArrayBytes && context.currentBlock() == &function->getEntryBlock();
+		if (init != NULL) {
+			GlobalVariable *table = new GlobalVariable(*context.module, storageType, true, GlobalValue::PrivateLinkage, init, id.name + ".init");
+			table->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+			builder.CreateMemCpy(array, align, table, align, bytes);
+		}
+		else if (!zeroed) {
+			// 入口块里的堆数组刚从calloc出来，已经是零
+			builder.CreateMemSet(array, builder.getInt8(0), bytes, align);
+		}
+	}
+	if (soa)
+		context.soaArrays.insert(array);
 	context.locals()[id.name] = array;
 	context.atps()[id.name] = arrayType;
 	context.tps()[id.name] = elementType;
 	return array;
 }
 
-Value* NArrayRef::codeGen(CodeGenContext& context) 
+Value* NArrayDeclarationS::codeGen(CodeGenContext& context)
 {
-	std::cout << "Creating ArrayRef declaration " << id.name << endl;
-	AllocaInst* arrayVar = reinterpret_cast<AllocaInst*>(context.locals()[id.name]);
-	Value* indexValue = index.codeGen(context);
-	ArrayType* arrayType = context.atps()[id.name];
-  	Type* elementType = context.tps()[id.name];
+	Value* ret = NULL;
+	for (NArrayDeclaration *decl : ArrayDeclarationList) {
+		ret = decl->codeGen(context);
+	}
+	return ret;
+}
+
+Value* NRecordDeclaration::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating record " << id.name << endl;
+	if (StructType::getTypeByName(MyContext, "record." + id.name) != NULL) {
+		std::cerr << "record " << id.name << " is already declared" << endl;
+		return NULL;
+	}
+	std::vector<Type*> fieldTypes;
+	std::vector<std::string> fieldNames;
+	for (NVariableDeclaration *field : fields) {
+		Type *fieldType = typeOf(field->type);
+		if (isString(fieldType)) {
+			std::cerr << "string field " << id.name << "." << field->id.name << " is not supported" << endl;
+			return NULL;
+		}
+		if (fieldType->isVoidTy()) {
+			std::cerr << "unknown type " << field->type.name << " for field " << id.name << "." << field->id.name << endl;
+			return NULL;
+		}
+		fieldTypes.push_back(fieldType);
+		fieldNames.push_back(field->id.name);
+	}
+	StructType *record = StructType::create(MyContext, fieldTypes, "record." + id.name);
+	context.recordFields[record] = fieldNames;
+	return NULL;
+}
+
+/* Marks the arena on entry to function, so releaseStorage can free what the
+   function's dynamic arrays took from it */
+static void markArena(CodeGenContext& context, Function *function)
+{
+	Value *&mark = context.arenaMarks[function];
+	if (mark == NULL) {
+		BasicBlock &entry = function->getEntryBlock();
+		IRBuilder<> entryBuilder(&entry, entry.getFirstInsertionPt());
+		mark = entryBuilder.CreateCall(context.module->getFunction("pascal_arena_mark"), {}, "arena.mark");
+	}
+}
+
+/* Emits the releases for everything a function allocated outside its
+   stack frame; called right before its return */
+void CodeGenContext::releaseStorage(Function *function)
+{
+	// 释放函数中在堆上分配的大数组
+	for (Value *heapArray : heapArrays[function]) {
+		Value *bytes = new BitCastInst(heapArray, Type::getInt8PtrTy(MyContext), "", currentBlock());
+		CallInst::Create(module->getFunction("pascal_free"), bytes, "", currentBlock());
+	}
+	heapArrays.erase(function);
+	// 字符串变量和临时串的堆内存
+	for (Value *slot : stringSlots[function]) {
+		CallInst::Create(module->getFunction("pascal_string_free"), slot, "", currentBlock());
+	}
+	stringSlots.erase(function);
+	// 函数里的文件数组解除映射；全局的文件数组在程序结束时一起解除
+	for (Value *desc : mappedArrays[function]) {
+		Value *bytes = new BitCastInst(desc, Type::getInt8PtrTy(MyContext), "", currentBlock());
+		CallInst::Create(module->getFunction("pascal_unmap_file"), bytes, "", currentBlock());
+	}
+	mappedArrays.erase(function);
+	// 动态数组的内存回到函数入口时的arena位置，一次性释放
+	auto mark = arenaMarks.find(function);
+	if (mark != arenaMarks.end()) {
+		CallInst::Create(module->getFunction("pascal_arena_release"), mark->second, "", currentBlock());
+		arenaMarks.erase(mark);
+	}
+	// 全局数组和引用参数的内存活到程序结束，缓冲的输出也在这时写出
+	if (function == mainFunction)
+		CallInst::Create(module->getFunction("pascal_static_release"), "", currentBlock());
+}
+
+/* Loads the length and data pointer of a dynamic array at the end of block */
+static DynArrayView loadDynArray(Value *slot, BasicBlock *block)
+{
+	StructType *descType = cast<StructType>(slotType(slot));
+	IRBuilder<> builder(block);
+	DynArrayView view;
+	view.length = builder.CreateLoad(descType->getElementType(0), builder.CreateStructGEP(descType, slot, 0), slot->getName() + ".len");
+	view.data = builder.CreateLoad(descType->getElementType(1), builder.CreateStructGEP(descType, slot, 1), slot->getName() + ".data");
+	return view;
+}
+
+/* Length and data pointer of a dynamic array. Inside loops they come from a
+   preheader (see cacheDynArrays) and depth is that loop's view level;
+   otherwise they are loaded in the current block and depth is -1. */
+static DynArrayView dynArrayView(CodeGenContext& context, Value *slot, int& depth)
+{
+	for (depth = (int)context.dynArrayViews.size() - 1; depth >= 0; depth--) {
+		auto it = context.dynArrayViews[depth].find(slot);
+		if (it != context.dynArrayViews[depth].end())
+			return it->second;
+	}
+	return loadDynArray(slot, context.currentBlock());
+}
+
+/* setlength(a, n), and length(a) of an array or a string. setlength takes a fresh zeroed block from
+   an arena and copies the elements that survive. A local array's blocks
+   are reclaimed with the rest of the function's arena on return; a global
+   array, or one reached through a parameter, may outlive the function and
+   grows in the program arena instead. */
+static Value *dynArrayBuiltin(CodeGenContext& context, NMethodCall& call)
+{
+	size_t arity = call.id.name == "setlength" ? 2 : 1;
+	NIdentifier *array = call.arguments.size() == arity ? dyn_cast<NIdentifier>(call.arguments[0]) : NULL;
+	bool declared = array != NULL && context.locals().find(array->name) != context.locals().end();
+	if (call.id.name == "length" && call.arguments.size() == 1 && (array == NULL || (declared && isStringValue(context.locals()[array->name])))) {
+		// length(s)：字符串的长度在第二个字段里
+		Value *string = call.arguments[0]->codeGen(context);
+		if (string == NULL || !isStringValue(string)) {
+			std::cerr << "length expects an array or a string" << endl;
+			return NULL;
+		}
+		IRBuilder<> builder(context.currentBlock());
+		Type *stringType = slotType(string);
+		return builder.CreateLoad(stringType->getStructElementType(1), builder.CreateStructGEP(stringType, string, 1), "length");
+	}
+	if (array == NULL || !declared) {
+		std::cerr << call.id.name << " expects an array variable" << endl;
+		return NULL;
+	}
+	Value *slot = context.locals()[array->name];
+	Type *indexType = Type::getInt64Ty(MyContext);
+	if (call.id.name == "length") {
+		if (context.dynArrays.count(slot)) {
+			int depth;
+			return dynArrayView(context, slot, depth).length;
+		}
+		if (context.atps().find(array->name) == context.atps().end()) {
+			std::cerr << array->name << " is not an array" << endl;
+			return NULL;
+		}
+		return ConstantInt::get(indexType, context.atps()[array->name]->getNumElements());
+	}
+	if (!context.dynArrays.count(slot)) {
+		std::cerr << "setlength on " << array->name << ", which is not a dynamic array" << endl;
+		return NULL;
+	}
+
+	if (context.readOnlySlots.count(slot)) {
+		std::cerr << "setlength on read-only array " << array->name << endl;
+		return NULL;
+	}
+	if (context.fileArrays.count(slot)) {
+		std::cerr << "setlength on file array " << array->name << ", whose length is the file's" << endl;
+		return NULL;
+	}
+
+	Value *length = call.arguments[1]->codeGen(context);
+	bool scoped = isa<AllocaInst>(slot);
+	if (scoped)
+		markArena(context, context.currentBlock()->getParent());
+
+	std::cout << "Creating setlength for " << array->name << endl;
+	Type *elementType = context.tps()[array->name];
+	StructType *descType = cast<StructType>(slotType(slot));
+	Value *elementBytes = ConstantInt::get(indexType, context.module->getDataLayout().getTypeAllocSize(elementType));
+	IRBuilder<> builder(context.currentBlock());
+	length = builder.CreateSelect(builder.CreateICmpSLT(length, ConstantInt::get(indexType, 0)), ConstantInt::get(indexType, 0), length, "newlen");
+	Value *lengthPtr = builder.CreateStructGEP(descType, slot, 0);
+	Value *dataPtr = builder.CreateStructGEP(descType, slot, 1);
+	Value *oldLength = builder.CreateLoad(indexType, lengthPtr);
+	Value *oldData = builder.CreateLoad(descType->getElementType(1), dataPtr);
+	Value *mem = builder.CreateCall(context.module->getFunction(scoped ? "pascal_arena_alloc" : "pascal_static_alloc"), builder.CreateNUWMul(length, elementBytes));
+	Value *data = builder.CreateBitCast(mem, descType->getElementType(1), array->name + ".data");
+	Value *keep = builder.CreateSelect(builder.CreateICmpULT(oldLength, length), oldLength, length);
+	builder.CreateMemCpy(data, MaybeAlign(16), oldData, MaybeAlign(16), builder.CreateNUWMul(keep, elementBytes));
+	builder.CreateStore(length, lengthPtr);
+	return builder.CreateStore(data, dataPtr);
+}
+
+/* readarray(a) reads numbers from the input into the elements of a, in
+   row-major order for multi-dimensional arrays and up to the current length
+   for dynamic ones; it stops early at the end of input and returns the
+   number of elements read */
+static Value *readArrayBuiltin(CodeGenContext& context, NMethodCall& call)
+{
+	NIdentifier *array = call.arguments.size() == 1 ? dyn_cast<NIdentifier>(call.arguments[0]) : NULL;
+	if (array == NULL || context.locals().find(array->name) == context.locals().end()) {
+		std::cerr << "readarray expects an array variable" << endl;
+		return NULL;
+	}
+	Value *slot = context.locals()[array->name];
+	bool dynamic = context.dynArrays.count(slot);
+	if (!dynamic && context.atps().find(array->name) == context.atps().end()) {
+		std::cerr << array->name << " is not an array" << endl;
+		return NULL;
+	}
+	if (context.readOnlySlots.count(slot)) {
+		std::cerr << "readarray on read-only array " << array->name << endl;
+		return NULL;
+	}
+	Type *elementType = context.tps()[array->name];
+	if (context.soaArrays.count(slot) || !(elementType->isIntegerTy(64) || elementType->isDoubleTy())) {
+		std::cerr << "readarray needs an array of int or double, " << array->name << " is not one" << endl;
+		return NULL;
+	}
+
+	std::cout << "Creating readarray for " << array->name << endl;
+	Type *indexType = Type::getInt64Ty(MyContext);
+	IRBuilder<> builder(context.currentBlock());
+	Value *data, *length;
+	if (dynamic) {
+		int depth;
+		DynArrayView view = dynArrayView(context, slot, depth);
+		data = view.data;
+		length = view.length;
+	}
+	else {
+		uint64_t elements = 1;
+		for (Type *dim = context.atps()[array->name]; isa<ArrayType>(dim); dim = dim->getArrayElementType())
+			elements *= dim->getArrayNumElements();
+		data = builder.CreateBitCast(slot, elementType->getPointerTo());
+		length = ConstantInt::get(indexType, elements);
+	}
+	Function *reader = context.module->getFunction(elementType->isDoubleTy() ? "pascal_read_doubles" : "pascal_read_ints");
+	return builder.CreateCall(reader, { data, length }, "readcount");
+}
+
+/* Returns the shared cold trap block of the current function */
+static BasicBlock *trapBlock(CodeGenContext& context)
+{
+	Function *function = context.currentBlock()->getParent();
+	BasicBlock *&trap = context.trapBlocks[function];
+	if (trap == NULL) {
+		trap = BasicBlock::Create(MyContext, "bounds.trap", function);
+		// 越界之前的输出还在缓冲里，先写出去
+		CallInst::Create(context.module->getFunction("flush"), "", trap);
+		Function *trapFn = Intrinsic::getDeclaration(context.module, Intrinsic::trap);
+		CallInst::Create(trapFn, "", trap);
+		new UnreachableInst(MyContext, trap);
+	}
+	return trap;
+}
+
+/* Matches index expressions of the form  i, i + c, c + i, i - c, where c
+   is a literal or a named constant */
+static bool affineIndex(CodeGenContext& context, NExpression& index, std::string& iter, long long& offset)
+{
+	if (NIdentifier *id = dyn_cast<NIdentifier>(&index)) {
+		iter = id->name;
+		offset = 0;
+		return true;
+	}
+	NBinaryOperator *binop = dyn_cast<NBinaryOperator>(&index);
+	if (binop == NULL || (binop->op != TPLUS && binop->op != TMINUS))
+		return false;
+	NIdentifier *id = dyn_cast<NIdentifier>(&binop->lhs);
+	ConstantInt *c = dyn_cast_or_null<ConstantInt>(foldConstant(context, binop->rhs));
+	if ((id == NULL || c == NULL) && binop->op == TPLUS) {
+		id = dyn_cast<NIdentifier>(&binop->rhs);
+		c = dyn_cast_or_null<ConstantInt>(foldConstant(context, binop->lhs));
+	}
+	if (id == NULL || c == NULL || namedConstant(context, id->name) != NULL)
+		return false;
+	iter = id->name;
+	offset = binop->op == TPLUS ? c->getSExtValue() : -c->getSExtValue();
+	return true;
+}
+
+/* -fbounds-check: guards an array access unless it can be proven in bounds.
+   Constant indices are checked at compile time; indices i + c over the
+   variable of an enclosing loop that FORStatement versions (an innermost
+   loop whose body can not change it) are proven once per loop on the
+   recorded requirement. size is a constant
+   for static arrays and the loaded length (from view level depth) for
+   dynamic ones. */
+static void checkIndex(CodeGenContext& context, NExpression& index, Value *indexValue, Value *size, int depth)
+{
+	if (!context.boundsCheck)
+		return;
+	ConstantInt *constSize = dyn_cast<ConstantInt>(size);
+	if (ConstantInt *c = dyn_cast<ConstantInt>(indexValue)) {
+		if (constSize != NULL && c->getSExtValue() >= 0 && c->getSExtValue() < constSize->getSExtValue())
+			return;
+		if (constSize != NULL)
+			std::cerr << "warning: constant index " << c->getSExtValue() << " is out of bounds" << endl;
+	}
+	std::string iter;
+	long long offset;
+	if (affineIndex(context, index, iter, offset)) {
+		LoopRange *range = context.findLoopRange(iter);
+		if (range != NULL && constSize != NULL) {
+			range->lo = std::max(range->lo, -offset);
+			range->hi = std::min(range->hi, constSize->getSExtValue() - 1 - offset);
+			return;
+		}
+		// 长度必须在循环外已经加载，才能放到循环前面去检查
+		if (range != NULL && depth >= 0 && (size_t)depth < range->viewDepth) {
+			range->lo = std::max(range->lo, -offset);
+			range->lengths.push_back(std::make_pair(offset, size));
+			return;
+		}
+	}
+
+	BasicBlock *okBB = BasicBlock::Create(MyContext, "bounds.ok", context.currentBlock()->getParent());
+	Value *inBounds = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_ULT, indexValue, size, "bounds", context.currentBlock());
+	BranchInst *br = BranchInst::Create(okBB, trapBlock(context), inBounds, context.currentBlock());
+	br->setMetadata(LLVMContext::MD_prof, MDBuilder(MyContext).createBranchWeights(1 << 20, 1));
+
+	std::map<std::string, Value*> templocals = context.locals();
+	std::map<std::string, Type*> temptps = context.tps();
+	std::map<std::string, ArrayType*> tempatps = context.atps();
+	context.popBlock();
+	context.pushBlock(okBB);
+	context.setTbs(templocals, temptps, tempatps);
+}
+
+/* Reports writes into const array parameters */
+static bool writable(CodeGenContext& context, const std::string& name)
+{
+	if (context.locals().find(name) != context.locals().end() && context.readOnlySlots.count(context.locals()[name])) {
+		std::cerr << "cannot assign to elements of read-only array " << name << endl;
+		return false;
+	}
+	return true;
+}
+
+/* GEP index of field in a record type, NULL if there is no such field */
+static Value *fieldIndex(CodeGenContext& context, Type *record, const NIdentifier& field)
+{
+	auto fields = context.recordFields.find(dyn_cast<StructType>(record));
+	if (fields == context.recordFields.end()) {
+		std::cerr << "." << field.name << " on a value that is not a record" << endl;
+		return NULL;
+	}
+	auto it = std::find(fields->second.begin(), fields->second.end(), field.name);
+	if (it == fields->second.end()) {
+		std::cerr << "no field " << field.name << " in " << record->getStructName().str() << endl;
+		return NULL;
+	}
+	return ConstantInt::get(Type::getInt32Ty(MyContext), it - fields->second.begin());
+}
+
+/* Address of name[i, j, ...] (or of its field) in a static or dynamic
+   array; one index per dimension, each checked against its own bound.
+   {$soa} arrays are addressed field first: &a.field[i, j]. */
+static Value *elementAddress(CodeGenContext& context, const std::string& name, const ExpressionRange& indices, const NIdentifier *field)
+{
+	auto local = context.locals().find(name);
+	if (local == context.locals().end() || !(context.dynArrays.count(local->second) || context.atps().count(name))) {
+		std::cerr << name << " is not an array" << endl;
+		return NULL;
+	}
+	Value* arrayVar = local->second;
+	Value *fieldNo = NULL;
+	if (field != NULL && (fieldNo = fieldIndex(context, context.tps()[name], *field)) == NULL)
+		return NULL;
+	if (context.dynArrays.count(arrayVar)) {
+		if (indices.size() != 1) {
+			std::cerr << "dynamic array " << name << " takes exactly one index" << endl;
+			return NULL;
+		}
+		Value* indexValue = indices[0]->codeGen(context);
+		int depth;
+		DynArrayView view = dynArrayView(context, arrayVar, depth);
+		checkIndex(context, *indices[0], indexValue, view.length, depth);
+		std::vector<Value*> gepIndices(1, indexValue);
+		if (fieldNo != NULL)
+			gepIndices.push_back(fieldNo);
+		return GetElementPtrInst::CreateInBounds(context.tps()[name], view.data, gepIndices, "", context.currentBlock());
+	}
+	bool soa = context.soaArrays.count(arrayVar);
+	if (soa && fieldNo == NULL) {
+		std::cerr << "elements of {$soa} array " << name << " can only be accessed one field at a time" << endl;
+		return NULL;
+	}
+	ArrayType* arrayType = context.atps()[name];
 	Constant* zero = ConstantInt::get(Type::getInt32Ty(MyContext), 0);
 	std::vector<Value*> gepIndices;
 	gepIndices.push_back(zero);
-	gepIndices.push_back(indexValue);
-	Value* elementPtr = GetElementPtrInst::CreateInBounds(arrayType, arrayVar, gepIndices, "", context.currentBlock());
-	return new LoadInst(elementType, elementPtr, "", false, context.currentBlock());
+	if (soa)
+		gepIndices.push_back(fieldNo);
+	Type *dimType = arrayType;
+	for (NExpression *index : indices) {
+		ArrayType *dim = dyn_cast<ArrayType>(dimType);
+		if (dim == NULL) {
+			std::cerr << "too many indices for array " << name << endl;
+			return NULL;
+		}
+		Value* indexValue = index->codeGen(context);
+		checkIndex(context, *index, indexValue, ConstantInt::get(Type::getInt64Ty(MyContext), dim->getNumElements()), -1);
+		gepIndices.push_back(indexValue);
+		dimType = dim->getElementType();
+	}
+	if (isa<ArrayType>(dimType)) {
+		std::cerr << "too few indices for array " << name << endl;
+		return NULL;
+	}
+	if (soa)
+		return GetElementPtrInst::CreateInBounds(slotType(arrayVar), arrayVar, gepIndices, "", context.currentBlock());
+	if (fieldNo != NULL)
+		gepIndices.push_back(fieldNo);
+	return GetElementPtrInst::CreateInBounds(arrayType, arrayVar, gepIndices, "", context.currentBlock());
+}
+
+/* Address of p.field or a[i, ...].field */
+static GetElementPtrInst *fieldAddress(CodeGenContext& context, NIdentifier& id, const ExpressionRange& indices, NIdentifier& field)
+{
+	if (context.locals().find(id.name) == context.locals().end()) {
+		std::cerr << "undeclared variable " << id.name << endl;
+		return NULL;
+	}
+	if (!indices.empty())
+		return cast_or_null<GetElementPtrInst>(elementAddress(context, id.name, indices, &field));
+	Value *slot = context.locals()[id.name];
+	Value *fieldNo = fieldIndex(context, slotType(slot), field);
+	if (fieldNo == NULL)
+		return NULL;
+	Value* gepIndices[] = { ConstantInt::get(Type::getInt32Ty(MyContext), 0), fieldNo };
+	return GetElementPtrInst::CreateInBounds(slotType(slot), slot, gepIndices, "", context.currentBlock());
+}
+
+Value* NFieldRef::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating field reference " << id.name << "." << field.name << endl;
+	GetElementPtrInst *fieldPtr = fieldAddress(context, id, indices, field);
+	if (fieldPtr == NULL)
+		return NULL;
+	return new LoadInst(fieldPtr->getResultElementType(), fieldPtr, id.name + "." + field.name, false, context.currentBlock());
+}
+
+Value* NFieldAssignment::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating field assignment " << id.name << "." << field.name << endl;
+	if (!writable(context, id.name))
+		return NULL;
+	GetElementPtrInst *fieldPtr = fieldAddress(context, id, indices, field);
+	if (fieldPtr == NULL)
+		return NULL;
+	Value* value = rhs.codeGen(context);
+	return new StoreInst(value, fieldPtr, false, context.currentBlock());
+}
+
+Value* NArrayRef::codeGen(CodeGenContext& context) 
+{
+	std::cout << "Creating ArrayRef declaration " << id.name << endl;
+	Value* elementPtr = elementAddress(context, id.name, indices, NULL);
+	if (elementPtr == NULL)
+		return NULL;
+	return new LoadInst(context.tps()[id.name], elementPtr, "", false, context.currentBlock());
 }
 
 Value* NArrayAssignment::codeGen(CodeGenContext& context) 
 {
-	AllocaInst* arrayVar = reinterpret_cast<AllocaInst*>(context.locals()[lhs.name]);
-	Value* indexValue = index.codeGen(context);
-	ArrayType* arrayType = context.atps()[lhs.name];
-  	Type* elementType = context.tps()[lhs.name];
-	PointerType* elementPtrType = elementType->getPointerTo();
-	Constant* zero = ConstantInt::get(elementType, 0);
-	std::vector<Value*> gepIndices;
-	gepIndices.push_back(zero);
-	gepIndices.push_back(indexValue);
-	Value* elementPtr = GetElementPtrInst::CreateInBounds(arrayType, arrayVar, gepIndices, "", context.currentBlock());
-	return new StoreInst(rhs.codeGen(context), elementPtr, false, context.currentBlock());
+	if (!writable(context, lhs.name))
+		return NULL;
+	Value* elementPtr = elementAddress(context, lhs.name, indices, NULL);
+	if (elementPtr == NULL)
+		return NULL;
+	Value* value = rhs.codeGen(context);
+	return new StoreInst(value, elementPtr, false, context.currentBlock());
 }
 
-Value* FORStatement::codeGen(CodeGenContext& context)
+static MDNode *loopHint(const char *name)
 {
-	
-	// //循环变量赋初值
-	NAssignment* inintal_assign= new NAssignment( iter,condition_start );
-	inintal_assign->codeGen(context);
-	// 每次增加的步长
+	return MDNode::get(MyContext, MDString::get(MyContext, name));
+}
+
+static MDNode *loopHint(const char *name, Constant *value)
+{
+	Metadata *ops[] = { MDString::get(MyContext, name), ConstantAsMetadata::get(value) };
+	return MDNode::get(MyContext, ops);
+}
+
+static MDNode *loopHint(const char *name, long long value)
+{
+	return loopHint(name, ConstantInt::get(Type::getInt32Ty(MyContext), value));
+}
 
-	for(auto k: context.locals()) {
-		cout<<"uuuuuuuuuuuu:"<<k.first<<endl;
+/* Parses the count of a loop directive: a positive integer that fits the
+   i32 operand of the hint */
+static bool loopCount(const std::string& text, long long& value)
+{
+	char *end;
+	errno = 0;
+	value = strtoll(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0' && errno == 0 && value > 0 && value <= INT_MAX;
+}
+
+/* Translates one {$...} loop directive into llvm.loop hints:
+     {$unroll}, {$unroll N}, {$unroll full}, {$nounroll}
+     {$vectorize}, {$vectorize width=N interleave=M}, {$novectorize}
+     {$interleave N}, {$nointerleave} */
+static void addLoopPragma(const std::string& pragma, SmallVector<Metadata*, 4>& ops)
+{
+	std::istringstream words(pragma.substr(2, pragma.size() - 3));
+	std::string name, arg;
+	long long value;
+	words >> name;
+	if (name == "unroll") {
+		if (!(words >> arg))
+			ops.push_back(loopHint("llvm.loop.unroll.enable"));
+		else if (arg == "full")
+			ops.push_back(loopHint("llvm.loop.unroll.full"));
+		else if (loopCount(arg, value))
+			ops.push_back(loopHint("llvm.loop.unroll.count", value));
+		else
+			std::cerr << "ignoring unroll count " << arg << " in " << pragma << ", expected a positive integer or full" << endl;
 	}
-	NInteger *iter_add_value = new NInteger(1);
+	else if (name == "nounroll") {
+		ops.push_back(loopHint("llvm.loop.unroll.disable"));
+	}
+	else if (name == "vectorize") {
+		ops.push_back(loopHint("llvm.loop.vectorize.enable", ConstantInt::getTrue(MyContext)));
+		while (words >> arg) {
+			size_t eq = arg.find('=');
+			bool counted = eq != std::string::npos && loopCount(arg.substr(eq + 1), value);
+			if (arg.compare(0, eq, "width") == 0 && counted)
+				ops.push_back(loopHint("llvm.loop.vectorize.width", value));
+			else if (arg.compare(0, eq, "interleave") == 0 && counted)
+				ops.push_back(loopHint("llvm.loop.interleave.count", value));
+			else
+				std::cerr << "ignoring vectorize option " << arg << " in " << pragma << endl;
+		}
+	}
+	else if (name == "novectorize") {
+		ops.push_back(loopHint("llvm.loop.vectorize.width", 1));
+	}
+	else if (name == "interleave") {
+		if (words >> arg && loopCount(arg, value))
+			ops.push_back(loopHint("llvm.loop.interleave.count", value));
+		else
+			std::cerr << "ignoring " << pragma << ", interleave needs a positive count" << endl;
+	}
+	else if (name == "nointerleave") {
+		ops.push_back(loopHint("llvm.loop.interleave.count", 1));
+	}
+	else {
+		std::cerr << "unknown loop directive " << pragma << endl;
+	}
+}
 
-	Function *TheFunction=context.currentBlock()->getParent();
+/* Builds a fresh llvm.loop identifier for a loop's backedge branch */
+static MDNode *loopMetadata(const PragmaList& pragmas)
+{
+	SmallVector<Metadata*, 4> ops(1); // slot 0 is the self reference
+	ops.push_back(loopHint("llvm.loop.mustprogress"));
+	for (auto& pragma : pragmas) {
+		addLoopPragma(pragma, ops);
+	}
+	MDNode *loopID = MDNode::getDistinct(MyContext, ops);
+	loopID->replaceOperandWith(0, loopID);
+	return loopID;
+}
 
-	BasicBlock *judgeBB=BasicBlock::Create(MyContext, "judge", TheFunction);
-	BasicBlock *workBB=BasicBlock::Create(MyContext, "work", TheFunction);
-	BasicBlock *endBB=BasicBlock::Create(MyContext, "end", TheFunction);
-	
-	BranchInst::Create	(judgeBB, context.currentBlock() );
-	cout<<"aaaaaaaaaaaaaaaaaaaaaa"<<endl;
-	std::map<std::string, Value*> templocals,templocals_1,templocals_2;
-	std::map<std::string, Type*> temptps, temptps_1, temptps_2;
-	std::map<std::string, ArrayType*> tempatps, tempatps_1, tempatps_2;
-	templocals=context.locals();temptps = context.tps();tempatps = context.atps();
+/* Collects the arrays a statement may resize: the ones it passes to
+   setlength or to a function, which may take them as var parameters.
+   callees gets the functions it calls, which may resize globals. */
+static void findSetLength(Node *node, std::set<std::string>& names, std::set<std::string>& callees)
+{
+	if (node == NULL)
+		return;
+	switch (node->kind) {
+		case NODE_BLOCK:
+			for (NStatement *stmt : cast<NBlock>(node)->statements) findSetLength(stmt, names, callees);
+			break;
+		case NODE_EXPRESSION_STATEMENT:
+			findSetLength(&cast<NExpressionStatement>(node)->expression, names, callees);
+			break;
+		case NODE_RETURN:
+			findSetLength(&cast<NReturnStatement>(node)->expression, names, callees);
+			break;
+		case NODE_VARIABLE_DECLARATIONS:
+			for (NVariableDeclaration *decl : cast<NVariableDeclarationS>(node)->VariableDeclarationList) findSetLength(decl->assignmentExpr, names, callees);
+			break;
+		case NODE_IF: {
+			NIFStatement *stmt = cast<NIFStatement>(node);
+			findSetLength(&stmt->condition, names, callees);
+			findSetLength(&stmt->ifStatement, names, callees);
+			findSetLength(&stmt->elseStatement, names, callees);
+			break;
+		}
+		case NODE_FOR: {
+			FORStatement *loop = cast<FORStatement>(node);
+			findSetLength(&loop->condition_start, names, callees);
+			findSetLength(&loop->condition_end, names, callees);
+			findSetLength(&loop->for_block, names, callees);
+			break;
+		}
+		case NODE_FOREACH:
+			findSetLength(&cast<FOREACHStatement>(node)->for_block, names, callees);
+			break;
+		case NODE_METHOD_CALL: {
+			NMethodCall *call = cast<NMethodCall>(node);
+			callees.insert(call->id.name);
+			for (NExpression *arg : call->arguments) {
+				NIdentifier *id = dyn_cast<NIdentifier>(arg);
+				if (id != NULL && call->id.name != "length") names.insert(id->name);
+			}
+			for (NExpression *arg : call->arguments) findSetLength(arg, names, callees);
+			break;
+		}
+		case NODE_ASSIGNMENT:
+			findSetLength(&cast<NAssignment>(node)->rhs, names, callees);
+			break;
+		case NODE_ARRAY_ASSIGNMENT: {
+			NArrayAssignment *assn = cast<NArrayAssignment>(node);
+			for (NExpression *index : assn->indices) findSetLength(index, names, callees);
+			findSetLength(&assn->rhs, names, callees);
+			break;
+		}
+		case NODE_FIELD_ASSIGNMENT: {
+			NFieldAssignment *assn = cast<NFieldAssignment>(node);
+			for (NExpression *index : assn->indices) findSetLength(index, names, callees);
+			findSetLength(&assn->rhs, names, callees);
+			break;
+		}
+		case NODE_FIELD_REF:
+			for (NExpression *index : cast<NFieldRef>(node)->indices) findSetLength(index, names, callees);
+			break;
+		case NODE_ARRAY_REF:
+			for (NExpression *index : cast<NArrayRef>(node)->indices) findSetLength(index, names, callees);
+			break;
+		case NODE_BINARY_OPERATOR:
+			findSetLength(&cast<NBinaryOperator>(node)->lhs, names, callees);
+			findSetLength(&cast<NBinaryOperator>(node)->rhs, names, callees);
+			break;
+		default:
+			break;
+	}
+}
+
+/* Whether the calls in body reach one of our functions, which may write
+   globals; callees are the names findSetLength collected */
+static bool callsInternal(CodeGenContext& context, const std::set<std::string>& callees)
+{
+	for (const std::string& name : callees) {
+		Function *callee = context.module->getFunction(name);
+		if (callee != NULL && !callee->isDeclaration())
+			return true;
+	}
+	return false;
+}
+
+/* Whether a statement contains a for or foreach loop */
+static bool containsLoop(Node *node)
+{
+	if (node == NULL)
+		return false;
+	switch (node->kind) {
+		case NODE_BLOCK:
+			for (NStatement *stmt : cast<NBlock>(node)->statements) {
+				if (containsLoop(stmt)) return true;
+			}
+			return false;
+		case NODE_IF:
+			return containsLoop(&cast<NIFStatement>(node)->ifStatement) || containsLoop(&cast<NIFStatement>(node)->elseStatement);
+		case NODE_FOR:
+		case NODE_FOREACH:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* Opens a view level for a loop: every dynamic array in scope that the body
+   never resizes gets its length and data pointer loaded once in predBB.
+   Stores through the data pointer could alias the descriptor, so the
+   optimizer can not hoist these loads by itself. Global arrays are skipped
+   when the body calls one of our functions. */
+static void cacheDynArrays(CodeGenContext& context, Node& body, BasicBlock *predBB)
+{
+	std::set<std::string> resized, callees;
+	findSetLength(&body, resized, callees);
+	bool writesGlobals = callsInternal(context, callees);
+	std::map<Value*, DynArrayView> views;
+	for (auto& local : context.locals()) {
+		if (!context.dynArrays.count(local.second) || resized.count(local.first))
+			continue;
+		if (writesGlobals && isa<GlobalVariable>(local.second))
+			continue;
+		int depth;
+		DynArrayView view = dynArrayView(context, local.second, depth);
+		if (depth < 0)
+			view = loadDynArray(local.second, predBB);
+		views[local.second] = view;
+	}
+	context.dynArrayViews.push_back(views);
+}
+
+/* Emits one copy of a for loop entered from predBB: a header with the
+   induction PHI, the body and a latch that exits to endBB. The context is
+   left positioned at the latch; returns the header. range, when given,
+   collects the bounds requirements of the body. */
+static BasicBlock *emitForLoop(FORStatement& loop, CodeGenContext& context, Value *iterSlot,
+		Value *start, Value *end, BasicBlock *predBB, BasicBlock *endBB, LoopRange *range)
+{
+	Function *TheFunction = predBB->getParent();
+	BasicBlock *headerBB = BasicBlock::Create(MyContext, "for.header", TheFunction);
+	cacheDynArrays(context, loop.for_block, predBB);
+	if (range != NULL)
+		range->viewDepth = context.dynArrayViews.size();
+
+	std::map<std::string, Value*> templocals;
+	std::map<std::string, Type*> temptps;
+	std::map<std::string, ArrayType*> tempatps;
+	templocals = context.locals(); temptps = context.tps(); tempatps = context.atps();
 	context.popBlock();
-	context.pushBlock(judgeBB);
+	context.pushBlock(headerBB);
 	context.setTbs(templocals, temptps, tempatps);
-	cout<<"bbbbbbbbbbbbbbbbbbbbbbbbbb"<<endl;
-	LoadInst *lditer = new LoadInst(context.locals()[iter.name]->getType(), context.locals()[iter.name], iter.name, false, context.currentBlock());
-	// ICmpInst *icmp = new ICmpInst(*context.currentBlock(), ICmpInst::ICMP_SLE , lditer, condition_end.codeGen(context) );	
-
-	// 
-	cout<<"ccccccccccccccccccccc"<<endl;
-	llvm::Value* cmp = llvm::CmpInst::Create(llvm::Instruction::ICmp, llvm::CmpInst::ICMP_SLE, lditer, condition_end.codeGen(context), "statisify", context.currentBlock());
-	// 
-	cout<<"ddddddddddddddddddddd"<<endl;
-	BranchInst::Create	(workBB, endBB, cmp ,context.currentBlock());	
-	
-	cout<<"eeeeeeeeeeeeeeeeeeeeeeeeeeee"<<endl;
-	templocals_1=context.locals();temptps_1 = context.tps();tempatps_1 = context.atps();
+
+	// 归纳变量放在寄存器里，只把当前值写回循环变量供循环体读取
+	PHINode *indvar = PHINode::Create(start->getType(), 2, loop.iter.name + ".iv", headerBB);
+	indvar->addIncoming(start, predBB);
+	new StoreInst(indvar, iterSlot, false, headerBB);
+
+	loop.for_block.codeGen(context);
+	context.dynArrayViews.pop_back();
+
+	BasicBlock *latchBB = BasicBlock::Create(MyContext, "for.latch", TheFunction);
+	BranchInst::Create(latchBB, context.currentBlock());
+	templocals = context.locals(); temptps = context.tps(); tempatps = context.atps();
 	context.popBlock();
-	context.pushBlock(workBB);
-	context.setTbs(templocals_1, temptps_1, tempatps_1);
+	context.pushBlock(latchBB);
+	context.setTbs(templocals, temptps, tempatps);
 
-	for_block.codeGen(context);
-	
-	NBinaryOperator* additer=new NBinaryOperator(iter, TPLUS,  *iter_add_value );
-	NAssignment *add_one_to_iter = new NAssignment(iter,*additer);
-	add_one_to_iter->codeGen(context);
-	BranchInst::Create	(	judgeBB, context.currentBlock() );
+	// 先比较再自增，自增永远不会溢出，可以标记nsw
+	Value *exitcond = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_EQ, indvar, end, "for.exitcond", latchBB);
+	BinaryOperator *next = BinaryOperator::CreateNSWAdd(indvar, ConstantInt::get(indvar->getType(), 1), loop.iter.name + ".next", latchBB);
+	indvar->addIncoming(next, latchBB);
+	BranchInst *backedge = BranchInst::Create(endBB, headerBB, exitcond, latchBB);
+	backedge->setMetadata(LLVMContext::MD_loop, loopMetadata(loop.pragmas));
+	return headerBB;
+}
+
+Value* FORStatement::codeGen(CodeGenContext& context)
+{
+	std::cout << "Creating for loop over " << iter.name << endl;
+	if (context.locals().find(iter.name) == context.locals().end()) {
+		std::cerr << "undeclared variable " << iter.name << endl;
+		return NULL;
+	}
+	if (namedConstant(context, iter.name) != NULL) {
+		std::cerr << "for loop variable " << iter.name << " is a constant" << endl;
+		return NULL;
+	}
+	// 迭代次数在进入循环时就定了，循环体不能再改循环变量
+	if (std::find(context.forVariables.begin(), context.forVariables.end(), iter.name) != context.forVariables.end()) {
+		std::cerr << "for loop variable " << iter.name << " is already used by an enclosing for loop" << endl;
+		return NULL;
+	}
+	Value *iterSlot = context.locals()[iter.name];
+	context.forVariables.push_back(iter.name);
+
+	// 上下界只在preheader中计算一次
+	Value *start = condition_start.codeGen(context);
+	Value *end = condition_end.codeGen(context);
+	BasicBlock *preheaderBB = context.currentBlock();
+	Function *TheFunction = preheaderBB->getParent();
+	BasicBlock *endBB = BasicBlock::Create(MyContext, "for.end");
+
+	// start > end 时整个循环一次都不执行，循环本身在latch中判断
+	Value *guard = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_SLE, start, end, "for.guard", preheaderBB);
+
+	// 只有循环体改不了循环变量时，i + c 的范围才能在循环前证明：赋值已经被
+	// 拒绝，主程序里的循环变量是全局变量，只有我们的函数能改它，所以循环体
+	// 不能调用它们；只对最内层循环版本化，否则嵌套循环的代码量按层数指数增长
+	std::set<std::string> resized, callees;
+	findSetLength(&for_block, resized, callees);
+	bool versioned = context.boundsCheck && !callsInternal(context, callees) && !containsLoop(&for_block);
 
+	if (!versioned) {
+		BasicBlock *headerBB = emitForLoop(*this, context, iterSlot, start, end, preheaderBB, endBB, NULL);
+		BranchInst::Create(headerBB, endBB, guard, preheaderBB);
+	}
+	else {
+		// 循环版本化：先生成不带检查的循环，循环体里 a[i+c] 的访问只记录对
+		// [start, end] 的要求；preheader里检查一次，满足就走快速版本，
+		// 否则走每次访问都检查的版本，越界仍然在原来的位置trap
+		BasicBlock *versionBB = BasicBlock::Create(MyContext, "for.version", TheFunction);
+		BranchInst::Create(versionBB, endBB, guard, preheaderBB);
+		std::map<std::string, Value*> templocals = context.locals();
+		std::map<std::string, Type*> temptps = context.tps();
+		std::map<std::string, ArrayType*> tempatps = context.atps();
+		context.popBlock();
+		context.pushBlock(versionBB);
+		context.setTbs(templocals, temptps, tempatps);
+
+		LoopRange range(iter.name);
+		context.loopRanges.push_back(&range);
+		BasicBlock *fastBB = emitForLoop(*this, context, iterSlot, start, end, versionBB, endBB, &range);
+		context.loopRanges.pop_back();
+
+		IRBuilder<> builder(versionBB);
+		Value *inBounds = builder.getTrue();
+		if (range.lo != LLONG_MIN)
+			inBounds = builder.CreateICmpSGE(start, ConstantInt::get(start->getType(), range.lo, true), "for.lo");
+		if (range.hi != LLONG_MAX) {
+			Value *hiOk = builder.CreateICmpSLE(end, ConstantInt::get(end->getType(), range.hi, true), "for.hi");
+			inBounds = isa<Constant>(inBounds) && cast<Constant>(inBounds)->isOneValue() ? hiOk : builder.CreateAnd(inBounds, hiOk, "for.inbounds");
+		}
+		for (auto& length : range.lengths) {
+			Value *limit = builder.CreateSub(length.second, ConstantInt::get(end->getType(), length.first, true));
+			Value *lenOk = builder.CreateICmpSLT(end, limit, "for.len");
+			inBounds = isa<Constant>(inBounds) && cast<Constant>(inBounds)->isOneValue() ? lenOk : builder.CreateAnd(inBounds, lenOk, "for.inbounds");
+		}
+		if (isa<Constant>(inBounds) && cast<Constant>(inBounds)->isOneValue()) {
+			builder.CreateBr(fastBB);
+		}
+		else {
+			context.popBlock();
+			context.pushBlock(versionBB);
+			context.setTbs(templocals, temptps, tempatps);
+			BasicBlock *slowBB = emitForLoop(*this, context, iterSlot, start, end, versionBB, endBB, NULL);
+			builder.CreateCondBr(inBounds, fastBB, slowBB);
+		}
+	}
+
+	context.forVariables.pop_back();
+
+	std::map<std::string, Value*> templocals = context.locals();
+	std::map<std::string, Type*> temptps = context.tps();
+	std::map<std::string, ArrayType*> tempatps = context.atps();
+	endBB->insertInto(TheFunction);
 	context.popBlock();
-	templocals_2=context.locals();temptps_2 = context.tps();tempatps_2 = context.atps();
 	context.pushBlock(endBB);
-	context.setTbs(templocals_2, temptps_2, tempatps_2);
-	return cmp;
+	context.setTbs(templocals, temptps, tempatps);
+	return guard;
 }
 
 Value* FOREACHStatement::codeGen(CodeGenContext& context)
 {
-	
-	// //循环变量赋初值
-	AllocaInst *alloc_index = new AllocaInst(Type::getInt64Ty(MyContext),4, "index", context.currentBlock());
-	context.locals()["index"] = alloc_index;
-	// 每次增加的步长
-	NInteger *iter_add_value = new NInteger(1);
+	std::cout << "Creating foreach loop over " << id.name << endl;
+	Value* arrayVar = context.locals().find(id.name) == context.locals().end() ? NULL : context.locals()[id.name];
+	bool dynamic = arrayVar != NULL && context.dynArrays.count(arrayVar);
+	if (!dynamic && context.atps().find(id.name) == context.atps().end()) {
+		std::cerr << id.name << " is not an array" << endl;
+		return NULL;
+	}
+	if (context.soaArrays.count(arrayVar)) {
+		std::cerr << "foreach over {$soa} array " << id.name << " is not supported, index its fields instead" << endl;
+		return NULL;
+	}
+	Type* elementType = context.tps()[id.name];
+	Type *indexType = Type::getInt64Ty(MyContext);
 
-	Function *TheFunction=context.currentBlock()->getParent();
+	// 动态数组的长度和数据指针在进入循环前取一次，循环体里改变长度不影响本次遍历
+	DynArrayView view;
+	Value *tripCount;
+	if (dynamic) {
+		int depth;
+		view = dynArrayView(context, arrayVar, depth);
+		tripCount = view.length;
+	}
+	else {
+		// 多维数组按行主序遍历全部元素
+		uint64_t elements = 1;
+		for (Type *dim = context.atps()[id.name]; isa<ArrayType>(dim); dim = dim->getArrayElementType())
+			elements *= dim->getArrayNumElements();
+		tripCount = ConstantInt::get(indexType, elements);
+	}
 
-	BasicBlock *judgeBB=BasicBlock::Create(MyContext, "judge", TheFunction);
-	BasicBlock *workBB=BasicBlock::Create(MyContext, "work", TheFunction);
-	BasicBlock *endBB=BasicBlock::Create(MyContext, "end", TheFunction);
-	
-	BranchInst::Create	(judgeBB, context.currentBlock() );
-	cout<<"aaaaaaaaaaaaaaaaaaaaaa"<<endl;
-	std::map<std::string, Value*> templocals,templocals_1,templocals_2;
-	std::map<std::string, Type*> temptps, temptps_1, temptps_2;
-	std::map<std::string, ArrayType*> tempatps, tempatps_1, tempatps_2;
-	templocals=context.locals();temptps = context.tps();tempatps = context.atps();
+	BasicBlock *preheaderBB = context.currentBlock();
+	Function *TheFunction = preheaderBB->getParent();
+
+	// 循环变量没有声明时，在入口块里为它分配一个可提升到寄存器的槽
+	Value *iterSlot;
+	if (context.locals().find(iter.name) != context.locals().end() && namedConstant(context, iter.name) == NULL) {
+		iterSlot = context.locals()[iter.name];
+	}
+	else {
+		iterSlot = entryAlloca(TheFunction, elementType, iter.name);
+	}
+
+	BasicBlock *headerBB = BasicBlock::Create(MyContext, "foreach.header", TheFunction);
+	BasicBlock *endBB = BasicBlock::Create(MyContext, "foreach.end");
+	cacheDynArrays(context, for_block, preheaderBB);
+	if (dynamic) {
+		Value *nonEmpty = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_SGT, tripCount, ConstantInt::get(indexType, 0), "foreach.guard", preheaderBB);
+		BranchInst::Create(headerBB, endBB, nonEmpty, preheaderBB);
+	}
+	else if (cast<ConstantInt>(tripCount)->isZero()) {
+		BranchInst::Create(endBB, preheaderBB);
+	}
+	else {
+		BranchInst::Create(headerBB, preheaderBB);
+	}
+
+	std::map<std::string, Value*> templocals;
+	std::map<std::string, Type*> temptps;
+	std::map<std::string, ArrayType*> tempatps;
+	templocals = context.locals(); temptps = context.tps(); tempatps = context.atps();
 	context.popBlock();
-	context.pushBlock(judgeBB);
+	context.pushBlock(headerBB);
 	context.setTbs(templocals, temptps, tempatps);
-	cout<<"bbbbbbbbbbbbbbbbbbbbbbbbbb"<<endl;
-	// LoadInst *lditer = new LoadInst(context.locals()[iter.name]->getType(), context.locals()[iter.name], iter.name, false, context.currentBlock());
-	// ICmpInst *icmp = new ICmpInst(*context.currentBlock(), ICmpInst::ICMP_SLE , lditer, condition_end.codeGen(context) );	
-
-	// 
-	cout<<"ccccccccccccccccccccc"<<endl;
-	llvm::Value* cmp = llvm::CmpInst::Create(llvm::Instruction::ICmp, llvm::CmpInst::ICMP_SLE, alloc_index, NInteger(5).codeGen(context), "statisify", context.currentBlock());
-	// 
-	cout<<"ddddddddddddddddddddd"<<endl;
-	BranchInst::Create(workBB, endBB, cmp ,context.currentBlock());	
-	
-	// cout<<"eeeeeeeeeeeeeeeeeeeeeeeeeeee"<<endl;
-	templocals_1=context.locals();temptps_1 = context.tps();tempatps_1 = context.atps();
+	context.locals()[iter.name] = iterSlot;
+
+	// 下标只在寄存器里，取值时用inbounds GEP，下标不会越界所以无需检查
+	PHINode *index = PHINode::Create(indexType, 2, "foreach.index", headerBB);
+	index->addIncoming(ConstantInt::get(indexType, 0), preheaderBB);
+	Value* elementPtr;
+	if (dynamic) {
+		elementPtr = GetElementPtrInst::CreateInBounds(elementType, view.data, index, "", headerBB);
+	}
+	else {
+		ArrayType *arrayType = context.atps()[id.name];
+		if (arrayType->getElementType() == elementType) {
+			Value* gepIndices[] = { ConstantInt::get(indexType, 0), index };
+			elementPtr = GetElementPtrInst::CreateInBounds(arrayType, arrayVar, gepIndices, "", headerBB);
+		}
+		else {
+			std::vector<Value*> zeros(1, ConstantInt::get(indexType, 0));
+			for (Type *dim = arrayType; isa<ArrayType>(dim); dim = dim->getArrayElementType())
+				zeros.push_back(zeros[0]);
+			Value *first = GetElementPtrInst::CreateInBounds(arrayType, arrayVar, zeros, "", headerBB);
+			elementPtr = GetElementPtrInst::CreateInBounds(elementType, first, index, "", headerBB);
+		}
+	}
+	Value* element = new LoadInst(elementType, elementPtr, id.name + ".elem", false, headerBB);
+	new StoreInst(element, iterSlot, false, headerBB);
+
+	for_block.codeGen(context);
+	context.dynArrayViews.pop_back();
+
+	BasicBlock *latchBB = BasicBlock::Create(MyContext, "foreach.latch", TheFunction);
+	BranchInst::Create(latchBB, context.currentBlock());
+	templocals = context.locals(); temptps = context.tps(); tempatps = context.atps();
 	context.popBlock();
-	context.pushBlock(workBB);
-	context.setTbs(templocals_1, temptps_1, tempatps_1);
-	AllocaInst *alloc_iter = new AllocaInst(context.tps()[id.name],4, "iter", context.currentBlock());
-	context.locals()["iter"] = alloc_iter;
-
-	AllocaInst* arrayVar = reinterpret_cast<AllocaInst*>(context.locals()[id.name]);
-	ArrayType* arrayType = context.atps()[id.name];
-  	Type* elementType = context.tps()[id.name];
-	Constant* zero = ConstantInt::get(Type::getInt32Ty(MyContext), 0);
-	std::vector<Value*> gepIndices;
-	gepIndices.push_back(zero);
-	gepIndices.push_back(alloc_index);
-	Value* elementPtr = GetElementPtrInst::CreateInBounds(arrayType, arrayVar, gepIndices, "", context.currentBlock());
-	Value* ldit = new LoadInst(elementType, elementPtr, "", false, context.currentBlock());
-	Value* stit = new StoreInst(ldit, alloc_iter, false, context.currentBlock());
-	// NIdentifier tpit = NIdentifier("iter");
+	context.pushBlock(latchBB);
+	context.setTbs(templocals, temptps, tempatps);
 
-	// Value* stit = new StoreInst(new NArrayRef(tpit, NInteger()), alloc_iter, false, context.currentBlock());
+	BinaryOperator *next = BinaryOperator::CreateNUWAdd(index, ConstantInt::get(indexType, 1), "foreach.next", latchBB);
+	next->setHasNoSignedWrap();
+	index->addIncoming(next, latchBB);
+	Value *exitcond = CmpInst::Create(Instruction::ICmp, CmpInst::ICMP_EQ, next, tripCount, "foreach.exitcond", latchBB);
+	BranchInst *backedge = BranchInst::Create(endBB, headerBB, exitcond, latchBB);
+	backedge->setMetadata(LLVMContext::MD_loop, loopMetadata(pragmas));
 
-	// for_block.codeGen(context);
-	
-	// NBinaryOperator* additer=new NBinaryOperator(iter_index, TPLUS,  *iter_add_value );
-	// NAssignment *add_one_to_iter = new NAssignment(iter_index, *additer);
-	// add_one_to_iter->codeGen(context);
-	// BranchInst::Create	(	judgeBB, context.currentBlock() );
-
-	// context.popBlock();
-	// templocals_2=context.locals();temptps_2 = context.tps();tempatps_2 = context.atps();
-	// context.pushBlock(endBB);
-	// context.setTbs(templocals_2, temptps_2, tempatps_2);
-	return cmp;
+	endBB->insertInto(TheFunction);
+	context.popBlock();
+	context.pushBlock(endBB);
+	context.setTbs(templocals, temptps, tempatps);
+	return backedge;
 }
@@ -1,4 +1,5 @@
 #include <stack>
+#include <set>
 #include <typeinfo>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
@@ -18,12 +19,26 @@
 #include <llvm/ExecutionEngine/MCJIT.h>
 #include <llvm/ExecutionEngine/GenericValue.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/Host.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <climits>
 
 using namespace llvm;
 
 class NBlock;
+class NStatement;
+class NAssignment;
+class NFunctionDeclaration;
 
-static LLVMContext MyContext;
+extern LLVMContext MyContext;
 
 class CodeGenBlock {
 public:
@@ -34,6 +49,42 @@ public:
     std::map<std::string, ArrayType*> atps;
 };
 
+/* Requirement on the [start, end] range of an enclosing for loop that makes
+   every a[iter + c] access in its body provably in bounds. Dynamic arrays
+   add end + c < length for lengths loaded in the first viewDepth levels of
+   dynArrayViews, which all dominate the loop. */
+class LoopRange {
+public:
+    std::string iter;
+    long long lo, hi;
+    std::vector<std::pair<long long, Value*> > lengths;
+    size_t viewDepth;
+    LoopRange(const std::string& iter) : iter(iter), lo(LLONG_MIN), hi(LLONG_MAX), viewDepth(0) { }
+};
+
+/* Block that direct self tail calls of a function jump back to, after
+   storing the new arguments into the parameter slots */
+class TailLoop {
+public:
+    BasicBlock *header;
+    std::vector<Value*> params;
+};
+
+/* Length and data pointer of a dynamic array, loaded once per loop */
+class DynArrayView {
+public:
+    Value *length;
+    Value *data;
+};
+
+/* A function the compile-time evaluator may run: its AST and the names in
+   scope where it was declared (constants with their value, globals NULL) */
+class ConstFunction {
+public:
+    NFunctionDeclaration *decl;
+    std::map<std::string, Constant*> scope;
+};
+
 class CodeGenContext {
     std::stack<CodeGenBlock *> blocks;
     Function *mainFunction;
@@ -41,21 +92,59 @@ class CodeGenContext {
 public:
 
     Module *module;
-    CodeGenContext() { module = new Module("main", MyContext); }
+    bool boundsCheck;
+    std::vector<LoopRange*> loopRanges;
+    std::vector<std::string> forVariables; // iterators of the enclosing for loops, which their bodies may not assign
+    std::map<Function*, BasicBlock*> trapBlocks;
+    std::map<Function*, std::vector<Value*> > heapArrays;
+    std::set<Value*> dynArrays; // slots holding a {length, data} descriptor
+    std::set<Value*> soaArrays; // record arrays stored one array per field
+    std::map<StructType*, std::vector<std::string> > recordFields;
+    std::set<Value*> readOnlySlots; // const parameters and {$readonly} file arrays
+    std::set<Value*> fileArrays; // descriptors of mapped files
+    std::map<Function*, std::vector<Value*> > mappedArrays; // local file arrays, unmapped on return
+    std::map<Function*, std::vector<Value*> > stringSlots; // string variables and temporaries, freed on return
+    std::set<Value*> stringTemps; // slots holding intermediate strings, which assignments move from
+    std::set<NAssignment*> tailCalls; // f := g(...) as the last action of f
+    std::map<Function*, TailLoop> tailLoops;
+    std::vector<std::map<Value*, DynArrayView> > dynArrayViews;
+    std::map<Function*, Value*> arenaMarks;
+    std::set<Function*> memoFunctions;
+    std::map<Function*, ConstFunction> constFunctions; // int functions of int parameters
+    std::map<std::pair<Function*, std::vector<long long> >, long long> constCalls;
+    std::set<std::pair<Function*, std::vector<long long> > > constCallsFailed;
+    CodeGenContext() { module = new Module("main", MyContext); boundsCheck = false; }
     
     void generateCode(NBlock& root);
+    void beginCode();
+    bool generateTopLevel(NStatement& stmt);
+    void endCode();
+    void linkRuntime();
+    void optimize();
+    void releaseStorage(Function *function);
     GenericValue runCode();
     std::map<std::string, Value*>& locals() { return blocks.top()->locals; }
     std::map<std::string, Type*>& tps() { return blocks.top()->tps; }
     std::map<std::string, ArrayType*>& atps() { return blocks.top()->atps; }
     BasicBlock *currentBlock() { return blocks.top()->block; }
+    bool isTopLevel() { return currentBlock()->getParent() == mainFunction; }
     void pushBlock(BasicBlock *block) { blocks.push(new CodeGenBlock()); blocks.top()->returnValue = NULL; blocks.top()->block = block; }
     void popBlock() { CodeGenBlock *top = blocks.top(); blocks.pop(); delete top; }
     void setCurrentReturnValue(Value *value) { blocks.top()->returnValue = value; }
     Value* getCurrentReturnValue() { return blocks.top()->returnValue; }
+    LoopRange* findLoopRange(const std::string& name) {
+        for (auto it = loopRanges.rbegin(); it != loopRanges.rend(); it++) {
+            if ((*it)->iter == name) return *it;
+        }
+        return NULL;
+    }
     void setTbs(std::map<std::string, Value*> trans_locals, std::map<std::string, Type*> trans_tps, std::map<std::string, ArrayType*> trans_atps){
         blocks.top()->locals=trans_locals;
         blocks.top()->tps=trans_tps;
         blocks.top()->atps=trans_atps;
     }
 };
+
+bool evaluateCall(CodeGenContext& context, Function *function, const std::vector<long long>& args, long long& result);
+bool mayEvaluate(CodeGenContext& context, const ConstFunction& function);
+
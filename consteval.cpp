@@ -0,0 +1,410 @@
+#include "node.h"
+#include "codegen.h"
+#include "parser.hpp"
+
+using namespace std;
+
+/* Compile-time evaluation of calls to our own functions with constant
+   arguments. The evaluator interprets a function's AST on 64-bit integers,
+   giving every construct the meaning codegen gives it. It gives up (and the
+   call is compiled normally) on anything that touches state outside the
+   call -- globals, arrays, runtime functions -- on reads of uninitialized
+   variables, on division by zero, and when it runs out of steps or depth. */
+
+static const long long MaxEvalSteps = 1000000;
+static const int MaxEvalDepth = 256;
+
+typedef std::pair<Function*, std::vector<long long> > ConstCall;
+
+/* Variables of one call: names map to slots per scope, and every
+   declaration gets one slot per call, as it gets one alloca. Names the
+   evaluator can not use (globals) map to Opaque. */
+class EvalFrame {
+public:
+	static const size_t Opaque = (size_t)-1;
+	std::map<std::string, size_t> names;
+	std::vector<long long> values;
+	std::vector<bool> set;
+	std::map<Node*, size_t> declared;
+	size_t bind(const std::string& name) {
+		names[name] = values.size();
+		values.push_back(0);
+		set.push_back(false);
+		return values.size() - 1;
+	}
+};
+
+class Evaluator {
+	CodeGenContext& context;
+	const std::map<std::string, Constant*>& scope;
+	EvalFrame frame;
+	std::string retName;
+	int depth;
+	long long& steps;
+
+	bool step() { return ++steps <= MaxEvalSteps; }
+	bool lookup(const std::string& name, size_t& slot);
+	bool eval(NExpression& expr, long long& value);
+	bool exec(Node& node);
+	bool assign(const std::string& name, long long value);
+public:
+	Evaluator(CodeGenContext& context, const ConstFunction& function, int depth, long long& steps) :
+		context(context), scope(function.scope), depth(depth), steps(steps) { }
+	bool call(const ConstFunction& function, const std::vector<long long>& args, long long& result);
+};
+
+static bool evaluate(CodeGenContext& context, Function *function, const std::vector<long long>& args,
+		int depth, long long& steps, long long& result);
+
+/* Slot of a variable; a name codegen would resolve to a global fails */
+bool Evaluator::lookup(const std::string& name, size_t& slot)
+{
+	auto it = frame.names.find(name);
+	if (it == frame.names.end())
+		it = frame.names.find(name + "__PASCAL__RET");
+	if (it == frame.names.end() || it->second == EvalFrame::Opaque)
+		return false;
+	slot = it->second;
+	return true;
+}
+
+bool Evaluator::assign(const std::string& name, long long value)
+{
+	size_t slot;
+	if (!lookup(name, slot))
+		return false;
+	frame.values[slot] = value;
+	frame.set[slot] = true;
+	return true;
+}
+
+bool Evaluator::eval(NExpression& expr, long long& value)
+{
+	if (!step())
+		return false;
+	switch (expr.kind) {
+		case NODE_INTEGER:
+			value = cast<NInteger>(&expr)->value;
+			return true;
+		case NODE_IDENTIFIER: {
+			size_t slot;
+			if (!lookup(cast<NIdentifier>(&expr)->name, slot) || !frame.set[slot])
+				return false;
+			value = frame.values[slot];
+			return true;
+		}
+		case NODE_BINARY_OPERATOR: {
+			NBinaryOperator *binop = cast<NBinaryOperator>(&expr);
+			long long l, r;
+			if (!eval(binop->lhs, l) || !eval(binop->rhs, r))
+				return false;
+			// 和生成的代码一样按64位补码回绕；比较运算是减法
+			unsigned long long a = l, b = r;
+			switch (binop->op) {
+				case TPLUS:		value = (long long)(a + b); return true;
+				case TMINUS:	value = (long long)(a - b); return true;
+				case TMUL:		value = (long long)(a * b); return true;
+				case TDIV:
+					if (r == 0 || (l == LLONG_MIN && r == -1))
+						return false;
+					value = l / r;
+					return true;
+				case TCLT: case TCLE:	value = (long long)(b - a); return true;
+				case TCGT: case TCGE:	value = (long long)(a - b); return true;
+			}
+			return false;
+		}
+		case NODE_ASSIGNMENT: {
+			NAssignment *assn = cast<NAssignment>(&expr);
+			return eval(assn->rhs, value) && assign(assn->lhs.name, value);
+		}
+		case NODE_METHOD_CALL: {
+			NMethodCall *call = cast<NMethodCall>(&expr);
+			Function *callee = context.module->getFunction(call->id.name);
+			if (callee == NULL || call->arguments.size() != callee->arg_size())
+				return false;
+			std::vector<long long> args;
+			for (NExpression *arg : call->arguments) {
+				long long argValue;
+				if (!eval(*arg, argValue))
+					return false;
+				args.push_back(argValue);
+			}
+			return evaluate(context, callee, args, depth + 1, steps, value);
+		}
+		case NODE_BLOCK:
+			return exec(expr);
+		default:
+			return false;
+	}
+}
+
+bool Evaluator::exec(Node& node)
+{
+	if (!step())
+		return false;
+	switch (node.kind) {
+		case NODE_BLOCK:
+			for (NStatement *stmt : cast<NBlock>(&node)->statements) {
+				if (!exec(*stmt))
+					return false;
+			}
+			return true;
+		case NODE_EXPRESSION_STATEMENT: {
+			long long value;
+			return eval(cast<NExpressionStatement>(&node)->expression, value);
+		}
+		case NODE_RETURN: {
+			// 函数的返回值总是最后的返回变量，这里只求值
+			NReturnStatement *stmt = cast<NReturnStatement>(&node);
+			long long value;
+			NIdentifier *id = dyn_cast<NIdentifier>(&stmt->expression);
+			return (id != NULL && id->name == retName) || eval(stmt->expression, value);
+		}
+		case NODE_VARIABLE_DECLARATIONS:
+			for (NVariableDeclaration *decl : cast<NVariableDeclarationS>(&node)->VariableDeclarationList) {
+				if (!exec(*decl))
+					return false;
+			}
+			return true;
+		case NODE_CONST_DECLARATION: {
+			NConstDeclaration *decl = cast<NConstDeclaration>(&node);
+			long long value;
+			if (!eval(decl->value, value))
+				return false;
+			size_t slot = frame.bind(decl->id.name);
+			frame.values[slot] = value;
+			frame.set[slot] = true;
+			return true;
+		}
+		case NODE_VARIABLE_DECLARATION: {
+			NVariableDeclaration *decl = cast<NVariableDeclaration>(&node);
+			if (decl->type.name != "int")
+				return false;
+			// 同一个声明在一次调用里只有一个槽，循环里再次执行时保留原来的值
+			auto it = frame.declared.find(decl);
+			if (it != frame.declared.end())
+				frame.names[decl->id.name] = it->second;
+			else
+				frame.declared[decl] = frame.bind(decl->id.name);
+			long long value;
+			return decl->assignmentExpr == NULL || (eval(*decl->assignmentExpr, value) && assign(decl->id.name, value));
+		}
+		case NODE_IF: {
+			NIFStatement *stmt = cast<NIFStatement>(&node);
+			long long cond;
+			if (!eval(stmt->condition, cond))
+				return false;
+			// 分支里的声明出了分支就看不到了
+			std::map<std::string, size_t> names = frame.names;
+			long long value;
+			bool ok = eval(cond > 0 ? stmt->ifStatement : stmt->elseStatement, value);
+			frame.names = names;
+			return ok;
+		}
+		case NODE_FOR: {
+			FORStatement *loop = cast<FORStatement>(&node);
+			long long start, end;
+			size_t slot;
+			auto it = frame.names.find(loop->iter.name);
+			if (it == frame.names.end() || it->second == EvalFrame::Opaque || !eval(loop->condition_start, start) || !eval(loop->condition_end, end))
+				return false;
+			slot = it->second;
+			if (start > end)
+				return true;
+			for (long long i = start; ; i++) {
+				frame.values[slot] = i;
+				frame.set[slot] = true;
+				long long value;
+				if (!eval(loop->for_block, value))
+					return false;
+				if (i == end)
+					return true;
+			}
+		}
+		default:
+			return false;
+	}
+}
+
+bool Evaluator::call(const ConstFunction& function, const std::vector<long long>& args, long long& result)
+{
+	NFunctionDeclaration& decl = *function.decl;
+	for (auto& name : scope) {
+		// 全局变量和非整数常量占住名字，用到它们时求值失败
+		ConstantInt *constant = dyn_cast_or_null<ConstantInt>(name.second);
+		if (constant == NULL) {
+			frame.names[name.first] = EvalFrame::Opaque;
+			continue;
+		}
+		frame.bind(name.first);
+		frame.values.back() = constant->getSExtValue();
+		frame.set.back() = true;
+	}
+	for (size_t i = 0; i < args.size(); i++) {
+		frame.bind(decl.arguments[i]->id.name);
+		frame.values.back() = args[i];
+		frame.set.back() = true;
+	}
+	retName = decl.id.name + "__PASCAL__RET";
+	size_t ret = frame.bind(retName);
+	if (!exec(decl.block) || !frame.set[ret])
+		return false;
+	result = frame.values[ret];
+	return true;
+}
+
+static bool evaluate(CodeGenContext& context, Function *function, const std::vector<long long>& args,
+		int depth, long long& steps, long long& result)
+{
+	auto it = context.constFunctions.find(function);
+	if (it == context.constFunctions.end() || depth > MaxEvalDepth)
+		return false;
+	// 被求值的函数没有副作用，同样的参数总得到同样的结果
+	ConstCall key(function, args);
+	auto known = context.constCalls.find(key);
+	if (known != context.constCalls.end()) {
+		result = known->second;
+		return true;
+	}
+	Evaluator evaluator(context, it->second, depth, steps);
+	if (!evaluator.call(it->second, args, result))
+		return false;
+	context.constCalls[key] = result;
+	return true;
+}
+
+/* Cheap scan of a function the evaluator could be asked to run: false when
+   evaluating it would always fail, so its tree need not be kept. Only the
+   constructs the evaluator handles may appear; names must be the function's
+   own (parameters, declarations, its result) or integer constants, and
+   calls must go to evaluable functions. */
+class EvalScan {
+	CodeGenContext& context;
+	const ConstFunction& function;
+	std::set<std::string> own;
+	void declare(Node *node);
+	bool known(const std::string& name);
+public:
+	EvalScan(CodeGenContext& context, const ConstFunction& function) : context(context), function(function) { }
+	bool scan(Node *node);
+	bool run();
+};
+
+/* Collects the names the function declares, wherever they are */
+void EvalScan::declare(Node *node)
+{
+	switch (node->kind) {
+		case NODE_BLOCK:
+			for (NStatement *stmt : cast<NBlock>(node)->statements) declare(stmt);
+			break;
+		case NODE_VARIABLE_DECLARATIONS:
+			for (NVariableDeclaration *decl : cast<NVariableDeclarationS>(node)->VariableDeclarationList) own.insert(decl->id.name);
+			break;
+		case NODE_CONST_DECLARATION:
+			own.insert(cast<NConstDeclaration>(node)->id.name);
+			break;
+		case NODE_IF:
+			declare(&cast<NIFStatement>(node)->ifStatement);
+			declare(&cast<NIFStatement>(node)->elseStatement);
+			break;
+		case NODE_FOR:
+			declare(&cast<FORStatement>(node)->for_block);
+			break;
+		default:
+			break;
+	}
+}
+
+bool EvalScan::known(const std::string& name)
+{
+	if (own.count(name))
+		return true;
+	auto it = function.scope.find(name);
+	return it != function.scope.end() && isa_and_nonnull<ConstantInt>(it->second);
+}
+
+bool EvalScan::scan(Node *node)
+{
+	switch (node->kind) {
+		case NODE_INTEGER:
+			return true;
+		case NODE_IDENTIFIER:
+			return known(cast<NIdentifier>(node)->name);
+		case NODE_BINARY_OPERATOR:
+			return scan(&cast<NBinaryOperator>(node)->lhs) && scan(&cast<NBinaryOperator>(node)->rhs);
+		case NODE_ASSIGNMENT:
+			return own.count(cast<NAssignment>(node)->lhs.name) && scan(&cast<NAssignment>(node)->rhs);
+		case NODE_METHOD_CALL: {
+			NMethodCall *call = cast<NMethodCall>(node);
+			Function *callee = context.module->getFunction(call->id.name);
+			if (call->id.name != function.decl->id.name && (callee == NULL || !context.constFunctions.count(callee)))
+				return false;
+			for (NExpression *arg : call->arguments) {
+				if (!scan(arg))
+					return false;
+			}
+			return true;
+		}
+		case NODE_BLOCK:
+			for (NStatement *stmt : cast<NBlock>(node)->statements) {
+				if (!scan(stmt))
+					return false;
+			}
+			return true;
+		case NODE_EXPRESSION_STATEMENT:
+			return scan(&cast<NExpressionStatement>(node)->expression);
+		case NODE_RETURN:
+			return scan(&cast<NReturnStatement>(node)->expression);
+		case NODE_VARIABLE_DECLARATIONS:
+			for (NVariableDeclaration *decl : cast<NVariableDeclarationS>(node)->VariableDeclarationList) {
+				if (!scan(decl))
+					return false;
+			}
+			return true;
+		case NODE_VARIABLE_DECLARATION: {
+			NVariableDeclaration *decl = cast<NVariableDeclaration>(node);
+			return decl->type.name == "int" && (decl->assignmentExpr == NULL || scan(decl->assignmentExpr));
+		}
+		case NODE_CONST_DECLARATION:
+			return scan(&cast<NConstDeclaration>(node)->value);
+		case NODE_IF: {
+			NIFStatement *stmt = cast<NIFStatement>(node);
+			return scan(&stmt->condition) && scan(&stmt->ifStatement) && scan(&stmt->elseStatement);
+		}
+		case NODE_FOR: {
+			FORStatement *loop = cast<FORStatement>(node);
+			return own.count(loop->iter.name) && scan(&loop->condition_start) && scan(&loop->condition_end) && scan(&loop->for_block);
+		}
+		default:
+			return false;
+	}
+}
+
+bool EvalScan::run()
+{
+	NFunctionDeclaration& decl = *function.decl;
+	for (NVariableDeclaration *arg : decl.arguments) own.insert(arg->id.name);
+	own.insert(decl.id.name);
+	declare(&decl.block);
+	return scan(&decl.block);
+}
+
+bool mayEvaluate(CodeGenContext& context, const ConstFunction& function)
+{
+	return EvalScan(context, function).run();
+}
+
+/* Runs function on constant arguments at compile time; false when it can
+   not be evaluated (then the call has to be made at run time) */
+bool evaluateCall(CodeGenContext& context, Function *function, const std::vector<long long>& args, long long& result)
+{
+	ConstCall key(function, args);
+	if (context.constCallsFailed.count(key))
+		return false;
+	long long steps = 0;
+	if (evaluate(context, function, args, 0, steps, result))
+		return true;
+	context.constCallsFailed.insert(key);
+	return false;
+}
@@ -8,25 +8,77 @@ extern int yyparse();
 extern NBlock* programBlock;
 
 
-llvm::Function* createPrintfFunction(CodeGenContext& context)
+/* Buffered output, see native.cpp */
+llvm::Function* createOutputFunctions(CodeGenContext& context)
 {
-    std::vector<llvm::Type*> printf_arg_types;
-    printf_arg_types.push_back(llvm::Type::getInt8PtrTy(MyContext)); //char*
+    llvm::Type* voidTy = llvm::Type::getVoidTy(MyContext);
 
-    llvm::FunctionType* printf_type =
-        llvm::FunctionType::get(
-            llvm::Type::getInt32Ty(MyContext), printf_arg_types, true);
+    llvm::Function *printi = llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, llvm::Type::getInt64Ty(MyContext), false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("printi"),
+                context.module
+           );
 
-    llvm::Function *func = llvm::Function::Create(
-                printf_type, llvm::Function::ExternalLinkage,
-                llvm::Twine("printf"),
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, llvm::Type::getDoubleTy(MyContext), false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("printd"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("flush"),
                 context.module
            );
-    func->setCallingConv(llvm::CallingConv::C);
-    return func;
+    return printi;
 }
 
-void createEchoFunction(CodeGenContext& context, llvm::Function* printfFn)
+/* Buffered input behind readi, readd, eof and readarray, see native.cpp */
+void createInputFunctions(CodeGenContext& context)
+{
+    llvm::Type* int64Ty = llvm::Type::getInt64Ty(MyContext);
+    llvm::Type* doubleTy = llvm::Type::getDoubleTy(MyContext);
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(int64Ty, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("readi"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(doubleTy, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("readd"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(int64Ty, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("eof"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(int64Ty, { int64Ty->getPointerTo(), int64Ty }, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_read_ints"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(int64Ty, { doubleTy->getPointerTo(), int64Ty }, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_read_doubles"),
+                context.module
+           );
+}
+
+void createEchoFunction(CodeGenContext& context, llvm::Function* printiFn)
 {
     std::vector<llvm::Type*> echo_arg_types;
     echo_arg_types.push_back(llvm::Type::getInt64Ty(MyContext));
@@ -42,38 +94,203 @@ void createEchoFunction(CodeGenContext& context, llvm::Function* printfFn)
            );
     llvm::BasicBlock *bblock = llvm::BasicBlock::Create(MyContext, "entry", func, 0);
 	context.pushBlock(bblock);
-    
-    const char *constValue = "%d\n";
-    llvm::Constant *format_const = llvm::ConstantDataArray::getString(MyContext, constValue);
-    llvm::GlobalVariable *var =
-        new llvm::GlobalVariable(
-            *context.module, llvm::ArrayType::get(llvm::IntegerType::get(MyContext, 8), strlen(constValue)+1),
-            true, llvm::GlobalValue::PrivateLinkage, format_const, ".str");
-    llvm::Constant *zero =
-        llvm::Constant::getNullValue(llvm::IntegerType::getInt32Ty(MyContext));
-
-    std::vector<llvm::Constant*> indices;
-    indices.push_back(zero);
-    indices.push_back(zero);
-    llvm::Constant *var_ref = llvm::ConstantExpr::getGetElementPtr(
-	llvm::ArrayType::get(llvm::IntegerType::get(MyContext, 8), strlen(constValue)+1),
-        var, indices);
-
-    std::vector<Value*> args;
-    args.push_back(var_ref);
 
     Function::arg_iterator argsValues = func->arg_begin();
     Value* toPrint = &*argsValues++;
     toPrint->setName("toPrint");
-    args.push_back(toPrint);
-    
-	CallInst *call = CallInst::Create(printfFn, makeArrayRef(args), "", bblock);
+
+	CallInst::Create(printiFn, toPrint, "", bblock);
 	ReturnInst::Create(MyContext, bblock);
 	context.popBlock();
 }
 
+/* Heap storage for arrays too large for the stack, see native.cpp */
+void createAllocFunctions(CodeGenContext& context)
+{
+    llvm::Type* bytePtrTy = llvm::Type::getInt8PtrTy(MyContext);
+
+    llvm::FunctionType* alloc_type =
+        llvm::FunctionType::get(bytePtrTy, llvm::Type::getInt64Ty(MyContext), false);
+    llvm::Function *alloc = llvm::Function::Create(
+                alloc_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_alloc"),
+                context.module
+           );
+    alloc->addRetAttr(llvm::Attribute::NoAlias);
+    alloc->addRetAttr(llvm::Attribute::NonNull);
+
+    llvm::FunctionType* free_type =
+        llvm::FunctionType::get(llvm::Type::getVoidTy(MyContext), bytePtrTy, false);
+    llvm::Function::Create(
+                free_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_free"),
+                context.module
+           );
+}
+
+/* Arenas behind dynamic arrays (setlength), see native.cpp */
+void createArenaFunctions(CodeGenContext& context)
+{
+    llvm::Type* bytePtrTy = llvm::Type::getInt8PtrTy(MyContext);
+
+    llvm::FunctionType* alloc_type =
+        llvm::FunctionType::get(bytePtrTy, llvm::Type::getInt64Ty(MyContext), false);
+    llvm::Function *alloc = llvm::Function::Create(
+                alloc_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_arena_alloc"),
+                context.module
+           );
+    alloc->addRetAttr(llvm::Attribute::NoAlias);
+    alloc->addRetAttr(llvm::Attribute::NonNull);
+
+    llvm::FunctionType* mark_type =
+        llvm::FunctionType::get(bytePtrTy, false);
+    llvm::Function::Create(
+                mark_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_arena_mark"),
+                context.module
+           );
+
+    llvm::FunctionType* release_type =
+        llvm::FunctionType::get(llvm::Type::getVoidTy(MyContext), bytePtrTy, false);
+    llvm::Function::Create(
+                release_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_arena_release"),
+                context.module
+           );
+
+    llvm::Function *staticAlloc = llvm::Function::Create(
+                alloc_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_static_alloc"),
+                context.module
+           );
+    staticAlloc->addRetAttr(llvm::Attribute::NoAlias);
+    staticAlloc->addRetAttr(llvm::Attribute::NonNull);
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(llvm::Type::getVoidTy(MyContext), false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_static_release"),
+                context.module
+           );
+}
+
+/* Mapped files behind file arrays, see native.cpp */
+void createFileArrayFunctions(CodeGenContext& context)
+{
+    llvm::Type* int64Ty = llvm::Type::getInt64Ty(MyContext);
+    llvm::Type* bytePtrTy = llvm::Type::getInt8PtrTy(MyContext);
+    llvm::Type* voidTy = llvm::Type::getVoidTy(MyContext);
+
+    llvm::FunctionType* map_type =
+        llvm::FunctionType::get(voidTy, { bytePtrTy, bytePtrTy, int64Ty, int64Ty, int64Ty, int64Ty }, false);
+    llvm::Function::Create(
+                map_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_map_file"),
+                context.module
+           );
+
+    llvm::FunctionType* unmap_type =
+        llvm::FunctionType::get(voidTy, bytePtrTy, false);
+    llvm::Function::Create(
+                unmap_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_unmap_file"),
+                context.module
+           );
+}
+
+/* The string type { data, length, capacity, small } and its runtime,
+   see native.cpp */
+void createStringFunctions(CodeGenContext& context)
+{
+    llvm::Type* int64Ty = llvm::Type::getInt64Ty(MyContext);
+    llvm::Type* voidTy = llvm::Type::getVoidTy(MyContext);
+    llvm::StructType* stringTy = llvm::StructType::create(MyContext,
+        { llvm::Type::getInt8PtrTy(MyContext), int64Ty, int64Ty, llvm::ArrayType::get(llvm::Type::getInt8Ty(MyContext), 16) },
+        "pascal.string");
+    llvm::Type* stringPtrTy = stringTy->getPointerTo();
+
+    const char *binary[] = { "pascal_string_assign", "pascal_string_move", "pascal_string_append" };
+    for (const char *name : binary) {
+        llvm::Function::Create(
+                    llvm::FunctionType::get(voidTy, { stringPtrTy, stringPtrTy }, false),
+                    llvm::Function::ExternalLinkage,
+                    llvm::Twine(name),
+                    context.module
+               );
+    }
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, { stringPtrTy, stringPtrTy, stringPtrTy }, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_string_concat"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(int64Ty, { stringPtrTy, stringPtrTy }, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_string_compare"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, { stringPtrTy, int64Ty }, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_string_from_int"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, stringPtrTy, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_string_free"),
+                context.module
+           );
+
+    llvm::Function::Create(
+                llvm::FunctionType::get(voidTy, stringPtrTy, false),
+                llvm::Function::ExternalLinkage,
+                llvm::Twine("prints"),
+                context.module
+           );
+}
+
+/* Hash tables behind memo functions, see native.cpp */
+void createMemoFunctions(CodeGenContext& context)
+{
+    llvm::Type* int64Ty = llvm::Type::getInt64Ty(MyContext);
+    llvm::Type* tablePtrTy = llvm::Type::getInt8PtrTy(MyContext)->getPointerTo();
+    llvm::Type* keyTy = int64Ty->getPointerTo();
+
+    llvm::FunctionType* lookup_type =
+        llvm::FunctionType::get(int64Ty, { tablePtrTy, int64Ty, keyTy, keyTy }, false);
+    llvm::Function::Create(
+                lookup_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_memo_lookup"),
+                context.module
+           );
+
+    llvm::FunctionType* store_type =
+        llvm::FunctionType::get(llvm::Type::getVoidTy(MyContext), { tablePtrTy, int64Ty, keyTy, int64Ty }, false);
+    llvm::Function::Create(
+                store_type, llvm::Function::ExternalLinkage,
+                llvm::Twine("pascal_memo_store"),
+                context.module
+           );
+}
+
 void createCoreFunctions(CodeGenContext& context){
-	llvm::Function* printfFn = createPrintfFunction(context);
-    createEchoFunction(context, printfFn);
+	llvm::Function* printiFn = createOutputFunctions(context);
+    createEchoFunction(context, printiFn);
+    createInputFunctions(context);
+    createAllocFunctions(context);
+    createArenaFunctions(context);
+    createMemoFunctions(context);
+    createFileArrayFunctions(context);
+    createStringFunctions(context);
+    // 运行时都是C函数，不会有异常穿过生成的代码
+    for (llvm::Function &func : context.module->functions())
+        func.addFnAttr(llvm::Attribute::NoUnwind);
 }
 
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "node.h"
+#include "parser.hpp"
+#include "lexer.h"
+
+/* Scanner microbenchmark: the hand-written lexer against the flex scanner
+   built from tokens.l with the prefix "flex". The input file is repeated
+   until it is about the given number of megabytes. Both hand the parser
+   the same values: parsed numbers, interned names and a new string for
+   each string literal.
+
+   make lexbench && ./lexbench example.txt 64 */
+
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
+YY_BUFFER_STATE flex_scan_bytes(const char *bytes, int length);
+void flex_delete_buffer(YY_BUFFER_STATE buffer);
+int flexlex();
+
+// parser.o不链接进来，flex扫描器要的yylval在这里定义
+YYSTYPE yylval;
+
+static const int Rounds = 5;
+
+/* Best time of Rounds runs of run(), which returns the number of tokens */
+template <typename Run>
+static double measure(const char *name, size_t size, Run run)
+{
+	double best = 1e30;
+	size_t count = 0;
+	for (int i = 0; i < Rounds; i++) {
+		auto start = std::chrono::steady_clock::now();
+		count = run();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() < best)
+			best = elapsed.count();
+	}
+	printf("%-22s %10zu tokens %8.3f s %10.1f MB/s\n", name, count, best, size / best / (1 << 20));
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s file [megabytes]\n", argv[0]);
+		return 1;
+	}
+	FILE *in = fopen(argv[1], "rb");
+	if (in == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	std::string text;
+	char block[65536];
+	size_t n;
+	while ((n = fread(block, 1, sizeof block, in)) > 0)
+		text.append(block, n);
+	fclose(in);
+	text.push_back('\n');
+
+	size_t megabytes = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+	// flex_scan_bytes只接受int长度
+	if (megabytes == 0 || megabytes >= 2048) {
+		fprintf(stderr, "megabytes must be between 1 and 2047\n");
+		return 1;
+	}
+	std::vector<char> source;
+	while (source.size() < megabytes << 20)
+		source.insert(source.end(), text.begin(), text.end());
+	size_t size = source.size();
+	source.resize(size + LexerPadding, 0);
+	printf("%s repeated to %zu bytes\n", argv[1], size);
+
+	std::vector<Token> tokens;
+	measure("scanTokens", size, [&]() {
+		tokens.clear();
+		scanTokens(source.data(), size, true, 1, tokens);
+		return tokens.size();
+	});
+	// yylex读窗口、取token的值，和flex的动作做的事一样，比的是这一项
+	double lexer = measure("yylex", size, [&]() {
+		size_t count = 0;
+		FILE *in = fmemopen(source.data(), size, "rb");
+		Lexer lexer(in);
+		YYSTYPE value;
+		for (int token; (token = lexer.lex(value)) != 0; count++) {
+			if (token == TSTRING)
+				delete value.string;
+		}
+		fclose(in);
+		return count;
+	});
+	double flex = measure("flex", size, [&]() {
+		size_t count = 0;
+		YY_BUFFER_STATE buffer = flex_scan_bytes(source.data(), (int)size);
+		for (int token; (token = flexlex()) != 0; count++) {
+			if (token == TSTRING)
+				delete yylval.string;
+		}
+		flex_delete_buffer(buffer);
+		return count;
+	});
+	printf("yylex is %.1fx flex\n", flex / lexer);
+	return 0;
+}
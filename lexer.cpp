@@ -0,0 +1,409 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "node.h"
+#include "parser.hpp"
+#include "lexer.h"
+
+/* Hand-written scanner; it replaced the flex one, which is kept in
+   tokens.l as the baseline for lexbench. The source is read a window at a
+   time and each window is cut into Token records in one pass. Runs of
+   blanks, identifier characters and digits are classified 16 bytes at a
+   time with SSE2, and keywords are found through a perfect hash on their
+   first and last characters and length. yylex then hands the records to
+   the parser with their values: numbers parsed, identifiers interned, and
+   a new string only for string literals. */
+
+FILE *yyin = NULL;
+
+/* -- Character runs -- */
+
+static inline bool identStart(unsigned char c)
+{
+	return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+}
+
+static inline bool isBlank(unsigned char c)
+{
+	return c == ' ' || c == '\t' || c == '\n';
+}
+
+static inline bool isDigit(unsigned char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline bool isIdent(unsigned char c)
+{
+	return identStart(c) || isDigit(c);
+}
+
+#ifdef __SSE2__
+static inline __m128i inRange(__m128i c, char lo, char hi)
+{
+	// 只用到ASCII，有符号比较就够了；0x80以上的字节是负数，不在任何范围里
+	return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8(hi + 1)));
+}
+
+static inline unsigned blankMask(__m128i c)
+{
+	__m128i m = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+	return _mm_movemask_epi8(_mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))));
+}
+
+static inline unsigned digitMask(__m128i c)
+{
+	return _mm_movemask_epi8(inRange(c, '0', '9'));
+}
+
+static inline unsigned identMask(__m128i c)
+{
+	// 或上0x20把大写字母变成小写，其它字符不会因此落进a-z
+	__m128i m = _mm_or_si128(inRange(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z'), inRange(c, '0', '9'));
+	return _mm_movemask_epi8(_mm_or_si128(m, _mm_cmpeq_epi8(c, _mm_set1_epi8('_'))));
+}
+
+/* First character at or after p that is not in the run; the zero padding
+   after the source always ends it */
+template <unsigned (*Mask)(__m128i), bool (*In)(unsigned char)>
+static inline const char *skipRun(const char *p)
+{
+	// 多数run只有一两个字节，先逐个看两个字节，再16个一组
+	if (!In(p[0]))
+		return p;
+	if (!In(p[1]))
+		return p + 1;
+	for (;;) {
+		unsigned outside = ~Mask(_mm_loadu_si128((const __m128i *)p)) & 0xFFFF;
+		if (outside != 0)
+			return p + __builtin_ctz(outside);
+		p += 16;
+	}
+}
+
+#define skipBlanks skipRun<blankMask, isBlank>
+#define skipDigits skipRun<digitMask, isDigit>
+#define skipIdent  skipRun<identMask, isIdent>
+#else
+static const char *skipBlanks(const char *p)
+{
+	while (isBlank(*p)) p++;
+	return p;
+}
+
+static const char *skipDigits(const char *p)
+{
+	while (isDigit(*p)) p++;
+	return p;
+}
+
+static const char *skipIdent(const char *p)
+{
+	while (isIdent(*p)) p++;
+	return p;
+}
+#endif
+
+/* -- Keywords -- */
+
+struct Keyword {
+	const char *name;
+	int token;
+};
+
+static const Keyword keywords[] = {
+	{ "for", TFOR }, { "to", TTO }, { "do", TDO }, { "begin", TBEGIN }, { "end", TEND },
+	{ "if", IF }, { "else", ELSE }, { "then", THEN }, { "program", PROGRAM },
+	{ "function", FUNCTION }, { "var", VAR }, { "extern", TEXTERN }, { "return", TRETURN },
+	{ "array", ARRAY }, { "of", OF }, { "foreach", TFOREACH }, { "in", IN },
+	{ "type", TTYPE }, { "record", TRECORD }, { "const", TCONST }, { "file", TFILE },
+};
+
+static const size_t KeywordSlots = 64;
+
+/* No two keywords share a slot; an identifier is a keyword only if it is
+   the one in its slot */
+static inline size_t keywordHash(const char *text, size_t length)
+{
+	return ((unsigned char)text[0] + 2 * (unsigned char)text[length - 1] + 7 * length) & (KeywordSlots - 1);
+}
+
+class KeywordTable {
+	const Keyword *slots[KeywordSlots];
+public:
+	KeywordTable() {
+		memset(slots, 0, sizeof slots);
+		for (const Keyword& keyword : keywords) {
+			size_t slot = keywordHash(keyword.name, strlen(keyword.name));
+			if (slots[slot] != NULL) {
+				fprintf(stderr, "keywords %s and %s share a hash slot\n", slots[slot]->name, keyword.name);
+				abort();
+			}
+			slots[slot] = &keyword;
+		}
+	}
+	int find(const char *text, size_t length) const {
+		const Keyword *keyword = slots[keywordHash(text, length)];
+		if (keyword != NULL && strncmp(keyword->name, text, length) == 0 && keyword->name[length] == '\0')
+			return keyword->token;
+		return TIDENTIFIER;
+	}
+};
+
+static const KeywordTable keywordTable;
+
+/* -- Scanning -- */
+
+static int lineOf(const char *source, const char *p, int line)
+{
+	for (const char *q = source; q < p; q++) line += *q == '\n';
+	return line;
+}
+
+static void unknownCharacter(const char *source, const char *p, int line)
+{
+	unsigned char c = *p;
+	if (c >= ' ' && c < 0x7f)
+		fprintf(stderr, "unknown character '%c' at line %d\n", c, lineOf(source, p, line));
+	else
+		fprintf(stderr, "unknown character 0x%02x at line %d\n", c, lineOf(source, p, line));
+}
+
+/* End of the string literal starting at p, or NULL if it does not close
+   on its line; '' inside a literal is a quote. open tells whether the
+   literal ran into end rather than a newline. */
+static const char *stringEnd(const char *p, const char *end, bool& open)
+{
+	for (p++; p < end; p++) {
+		if (*p == '\n')
+			return NULL;
+		if (*p != '\'')
+			continue;
+		if (p[1] != '\'')
+			return p + 1;
+		p++;
+	}
+	open = true;
+	return NULL;
+}
+
+/* Token of the one- or two-character operator at p; its length in length */
+static int operatorToken(const char *p, size_t& length)
+{
+	length = 1;
+	switch (*p) {
+		case '=':	if (p[1] == '=') { length = 2; return TCEQ; } return TEQUAL;
+		case '!':	if (p[1] == '=') { length = 2; return TCNE; } return 0;
+		case '<':	if (p[1] == '=') { length = 2; return TCLE; } return TCLT;
+		case '>':	if (p[1] == '=') { length = 2; return TCGE; } return TCGT;
+		case '(':	return TLPAREN;
+		case ')':	return TRPAREN;
+		case '{':	return TLBRACE;
+		case '}':	return TRBRACE;
+		case '.':	return TDOT;
+		case ',':	return TCOMMA;
+		case '+':	return TPLUS;
+		case '-':	return TMINUS;
+		case '*':	return TMUL;
+		case '/':	return TDIV;
+		case ':':	return COLON;
+		case ';':	return SEMICOLON;
+		case '[':	return SQLBRACE;
+		case ']':	return SQRBRACE;
+	}
+	return 0;
+}
+
+/* Characters that start no token are reported and skipped */
+size_t scanTokens(const char *source, size_t size, bool last, int line, std::vector<Token>& tokens)
+{
+	if (size > UINT32_MAX) {
+		fprintf(stderr, "source window is too large (%zu bytes)\n", size);
+		exit(1);
+	}
+	const char *end = source + size;
+	const char *p = source;
+	for (;;) {
+		p = skipBlanks(p);
+		if (p >= end)
+			break;
+		const char *start = p;
+		int token;
+		bool open = false;
+		if (identStart(*p)) {
+			p = skipIdent(p + 1);
+			token = keywordTable.find(start, p - start);
+		}
+		else if (*p >= '0' && *p <= '9') {
+			// 1. 和 1.5 都是double
+			p = skipDigits(p + 1);
+			token = TINTEGER;
+			if (*p == '.') {
+				p = skipDigits(p + 1);
+				token = TDOUBLE;
+			}
+		}
+		// 最后一个窗口里没有结束的字符串和pragma不算token，从第一个字符按运算符扫
+		else if (*p == '\'' && ((p = stringEnd(start, end, open)) != NULL || (open && !last))) {
+			token = TSTRING;
+		}
+		else if (start[0] == '{' && start[1] == '$' &&
+				 ((p = (const char *)memchr(start + 2, '}', end - start - 2)) != NULL || (open = !last))) {
+			p = p != NULL ? p + 1 : end;
+			token = TPRAGMA;
+		}
+		else {
+			size_t length;
+			p = start;
+			token = operatorToken(p, length);
+			p += token == 0 ? 1 : length;
+		}
+		// 碰到窗口末尾的token可能在还没读的数据里接着写，留给下一个窗口
+		if (!last && (open || p >= end))
+			return start - source;
+		if (token == 0) {
+			unknownCharacter(source, start, line);
+			continue;
+		}
+		tokens.push_back(Token{ (uint32_t)(start - source), (uint32_t)(p - start), token });
+	}
+	return size;
+}
+
+/* -- The parser's interface -- */
+
+Lexer::Lexer(FILE *in)
+	: in(in), buffer(LexerWindow + LexerPadding), size(0), consumed(0), last(false), line(1), next(0)
+{
+	memset(names, 0, sizeof names);
+}
+
+/* Moves the bytes not scanned yet to the front of the window, reads after
+   them and scans; false at the end of the source */
+bool Lexer::refill()
+{
+	tokens.clear();
+	next = 0;
+	while (tokens.empty()) {
+		if (last)
+			return false;
+		line = lineOf(buffer.data(), buffer.data() + consumed, line);
+		memmove(buffer.data(), buffer.data() + consumed, size - consumed);
+		size -= consumed;
+		size_t capacity = buffer.size() - LexerPadding;
+		if (size == capacity) {
+			// 一个token占满了整个窗口，窗口加倍再读
+			if (capacity * 2 > UINT32_MAX) {
+				fprintf(stderr, "token at line %d is too long\n", line);
+				exit(1);
+			}
+			capacity *= 2;
+			buffer.resize(capacity + LexerPadding);
+		}
+		size_t wanted = capacity - size;
+		size_t n = fread(buffer.data() + size, 1, wanted, in);
+		size += n;
+		if (n < wanted) {
+			if (ferror(in)) {
+				perror("can not read the source");
+				exit(1);
+			}
+			last = true;
+		}
+		memset(buffer.data() + size, 0, LexerPadding);
+		consumed = scanTokens(buffer.data(), size, last, line, tokens);
+	}
+	return true;
+}
+
+/* The interned name text[0, length) */
+const std::string *Lexer::intern(const char *text, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+	const std::string *&slot = names[(hash ^ hash >> 16) & (NameSlots - 1)];
+	if (slot == NULL || slot->size() != length || memcmp(slot->data(), text, length) != 0)
+		slot = &internName(std::string_view(text, length));
+	return slot;
+}
+
+/* The integer at text; like strtoll, values too large for a long long are
+   LLONG_MAX */
+static long long parseInteger(const char *text, size_t length)
+{
+	unsigned long long value = 0;
+	for (size_t i = 0; i < length; i++) {
+		value = value * 10 + (text[i] - '0');
+		if (value > LLONG_MAX)
+			return LLONG_MAX;
+	}
+	return value;
+}
+
+/* The double at text; strtod would also take an exponent or hex digits
+   after the token, so it gets a copy that ends with the token */
+static double parseDouble(const char *text, size_t length)
+{
+	char copy[64];
+	if (length < sizeof copy) {
+		memcpy(copy, text, length);
+		copy[length] = '\0';
+		return strtod(copy, NULL);
+	}
+	return strtod(std::string(text, length).c_str(), NULL);
+}
+
+/* 'it''s' -> it's */
+static std::string *unquote(const char *text, size_t length)
+{
+	std::string *s = new std::string();
+	for (size_t i = 1; i + 1 < length; i++) {
+		s->push_back(text[i]);
+		if (text[i] == '\'')
+			i++;
+	}
+	return s;
+}
+
+int Lexer::lex(YYSTYPE& value)
+{
+	// 上一个窗口的token都交出去以后才读下一个，它们的值在交出时已经取好
+	if (next == tokens.size() && !refill())
+		return 0;
+	const Token& token = tokens[next++];
+	const char *text = buffer.data() + token.offset;
+	switch (token.token) {
+		case TIDENTIFIER: case TPRAGMA:
+			value.name = intern(text, token.length);
+			break;
+		case TINTEGER:
+			value.integer = parseInteger(text, token.length);
+			break;
+		case TDOUBLE:
+			value.number = parseDouble(text, token.length);
+			break;
+		case TSTRING:
+			value.string = unquote(text, token.length);
+			break;
+		default:
+			value.token = token.token;
+			break;
+	}
+	return token.token;
+}
+
+int yylex()
+{
+	static Lexer *lexer = NULL;
+	if (lexer == NULL)
+		lexer = new Lexer(yyin != NULL ? yyin : stdin);
+	return lexer->lex(yylval);
+}
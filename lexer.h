@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+union YYSTYPE;
+
+/* One token of the window being scanned: the parser's token number and
+   where its text is in the window */
+struct Token {
+	uint32_t offset;
+	uint32_t length;
+	int token;
+};
+
+/* Zero bytes the scanner needs after the end of the source: it reads
+   whole 16-byte blocks and stops on the first byte outside a run */
+static const size_t LexerPadding = 32;
+
+/* Bytes read from the source at a time; a token longer than this grows the
+   window to hold it */
+static const size_t LexerWindow = 64 * 1024;
+
+/* Cuts source[0, size) into tokens; source must be followed by
+   LexerPadding zero bytes, and line is the line source starts on. Unless
+   last, a token that reaches size may go on in the data not read yet, so
+   scanning stops in front of it. Returns the bytes consumed. */
+size_t scanTokens(const char *source, size_t size, bool last, int line, std::vector<Token>& tokens);
+
+/* Tokens of a source read through a window of LexerWindow bytes, scanned
+   one window at a time as the parser asks for them */
+class Lexer {
+	FILE *in;
+	std::vector<char> buffer;
+	size_t size;		// source bytes in buffer
+	size_t consumed;	// bytes the tokens of this window cover
+	bool last;			// the rest of the source is in buffer
+	int line;			// line buffer[0] is on
+	std::vector<Token> tokens;
+	size_t next;
+	// 最近见过的名字，按名字的hash直接放，省掉大多数internName的查找
+	static const size_t NameSlots = 1024;
+	const std::string *names[NameSlots];
+	bool refill();
+	const std::string *intern(const char *text, size_t length);
+public:
+	explicit Lexer(FILE *in);
+	/* Next token and its value for the parser, 0 at the end */
+	int lex(YYSTYPE& value);
+};
@@ -26,6 +26,7 @@
 // }
 
 #include <iostream>
+#include <cstring>
 #include "codegen.h"
 #include "node.h"
 
@@ -33,28 +34,59 @@ using namespace std;
 
 extern int yyparse();
 extern NBlock* programBlock;
+extern FILE *yyin;
 
 void open_file(const char* filename) {
-	// openfile
-	freopen(filename, "r", stdin);
+	// 源程序从文件读，标准输入留给运行的程序(readi等)
+	yyin = fopen(filename, "r");
+	if (yyin == NULL) {
+		std::cerr << "can not open " << filename << endl;
+		exit(1);
+	}
 }
 
 void createCoreFunctions(CodeGenContext& context);
+void startStreaming(CodeGenContext& context);
 
 int main(int argc, char **argv)
 {
-	if (argc > 1) {
-		open_file(argv[1]);
+	bool boundsCheck = false;
+	bool streaming = false;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-fbounds-check") == 0) {
+			boundsCheck = true;
+		}
+		else if (strcmp(argv[i], "-fstream") == 0) {
+			streaming = true;
+		}
+		else {
+			open_file(argv[i]);
+		}
 	}
-	yyparse();
-	cout << programBlock << endl;
     // see http://comments.gmane.org/gmane.comp.compilers.llvm.devel/33877
 	InitializeNativeTarget();
 	InitializeNativeTargetAsmPrinter();
 	InitializeNativeTargetAsmParser();
 	CodeGenContext context;
+	context.boundsCheck = boundsCheck;
 	createCoreFunctions(context);
-	context.generateCode(*programBlock);
+	// -fstream：顶层的声明一归约就生成代码并释放语法树，内存只和最大的函数有关
+	if (streaming) {
+		context.beginCode();
+		startStreaming(context);
+	}
+	yyparse();
+	cout << programBlock << endl;
+	if (streaming) {
+		programBlock->codeGen(context);
+		context.endCode();
+	}
+	else {
+		context.generateCode(*programBlock);
+	}
+	// 生成代码之后不再需要语法树，整个arena一次释放
+	astArena.release();
+	programBlock = NULL;
 	context.runCode();
 	
 	return 0;
@@ -1,7 +1,755 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <charconv>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Buffered standard output behind printi, printd and flush. Numbers are
+   formatted into one large buffer with std::to_chars, which is handed to
+   the kernel in a single write when it fills, on flush, when main returns
+   and before the program stops on an error. The runtime is linked into
+   the JIT-ed module (see runtime.cpp), which can not use thread-local
+   storage or static destructors, and the programs are single-threaded. */
+static const size_t OutputBufferSize = 1 << 20;
+static const size_t MaxNumberChars = 32; // longest number printed plus newline
+
+struct OutputBuffer {
+    char *data;
+    size_t used;
+};
+
+static OutputBuffer output = { NULL, 0 };
+
+static void writeAll(const char *bytes, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(STDOUT_FILENO, bytes + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        done += n;
+    }
+}
+
+static void flushOutput(OutputBuffer& out)
+{
+    // 先清空stdio里的内容，保持和编译器自己输出的顺序
+    fflush(stdout);
+    writeAll(out.data, out.used);
+    out.used = 0;
+}
+
+static void outOfMemory(size_t bytes)
+{
+    flushOutput(output);
+    fprintf(stderr, "out of memory allocating %zu bytes\n", bytes);
+    exit(1);
+}
+
+/* Room for one more number; flushes when the buffer is almost full */
+static char *outputReserve(OutputBuffer& out)
+{
+    if (out.data == NULL) {
+        out.data = (char *)malloc(OutputBufferSize);
+        if (out.data == NULL)
+            outOfMemory(OutputBufferSize);
+    }
+    else if (OutputBufferSize - out.used < MaxNumberChars) {
+        flushOutput(out);
+    }
+    return out.data + out.used;
+}
 
 extern "C"
 void printi(long long val)
 {
-    printf("%lld\n", val);
+    char *p = outputReserve(output);
+    p = std::to_chars(p, output.data + OutputBufferSize, val).ptr;
+    *p++ = '\n';
+    output.used = p - output.data;
+}
+
+extern "C"
+void printd(double val)
+{
+    char *p = outputReserve(output);
+    p = std::to_chars(p, output.data + OutputBufferSize, val).ptr;
+    *p++ = '\n';
+    output.used = p - output.data;
+}
+
+extern "C"
+void flush()
+{
+    flushOutput(output);
+}
+
+/* Strings. The characters of a string are in small while they fit
+   (data is NULL then, so a string can be moved or returned by value);
+   longer ones are in a heap block of capacity bytes the string owns.
+   A string that copied a literal borrows the literal's characters
+   (capacity 0, data not NULL) until it is changed. The zero-initialized
+   struct is the empty string. The layout is pascal.string in corefn.cpp. */
+static const long long SmallStringChars = 16;
+
+struct PascalString {
+    const char *data;
+    long long length;
+    long long capacity;
+    char small[SmallStringChars];
+};
+
+static const char *stringChars(const PascalString *s)
+{
+    return s->data == NULL ? s->small : s->data;
+}
+
+static void stringClear(PascalString *s)
+{
+    if (s->capacity > 0)
+        free((void *)s->data);
+    s->data = NULL;
+    s->length = 0;
+    s->capacity = 0;
+}
+
+/* Writable room for length characters, keeping the first keep of them.
+   Heap blocks at least double when they grow, so appending is linear. */
+static char *stringReserve(PascalString *s, long long length, long long keep)
+{
+    if (s->capacity == 0 && length <= SmallStringChars) {
+        // 借用的字面量要改写时先拷进small
+        if (s->data != NULL)
+            memcpy(s->small, s->data, keep);
+        s->data = NULL;
+        return s->small;
+    }
+    if (s->capacity >= length)
+        return (char *)s->data;
+    long long capacity = 2 * s->capacity > length ? 2 * s->capacity : length;
+    if (capacity < 2 * SmallStringChars)
+        capacity = 2 * SmallStringChars;
+    char *block = (char *)malloc(capacity);
+    if (block == NULL)
+        outOfMemory(capacity);
+    memcpy(block, stringChars(s), keep);
+    if (s->capacity > 0)
+        free((void *)s->data);
+    s->data = block;
+    s->capacity = capacity;
+    return block;
+}
+
+extern "C"
+void pascal_string_assign(PascalString *dst, const PascalString *src)
+{
+    if (dst == src)
+        return;
+    if (src->data != NULL && src->capacity == 0) {
+        // 字面量不复制，只借用
+        stringClear(dst);
+        dst->data = src->data;
+        dst->length = src->length;
+        return;
+    }
+    char *p = stringReserve(dst, src->length, 0);
+    memcpy(p, stringChars(src), src->length);
+    dst->length = src->length;
+}
+
+/* Takes over the characters of src, which is left empty */
+extern "C"
+void pascal_string_move(PascalString *dst, PascalString *src)
+{
+    if (dst == src)
+        return;
+    stringClear(dst);
+    *dst = *src;
+    src->data = NULL;
+    src->length = 0;
+    src->capacity = 0;
+}
+
+extern "C"
+void pascal_string_append(PascalString *dst, const PascalString *src)
+{
+    long long length = dst->length;
+    long long n = src->length;
+    const char *chars = stringChars(src);
+    char *p = stringReserve(dst, length + n, length);
+    // s := s + s：原来的字符可能刚被搬走
+    memmove(p + length, src == dst ? p : chars, n);
+    dst->length = length + n;
+}
+
+extern "C"
+void pascal_string_concat(PascalString *dst, const PascalString *a, const PascalString *b)
+{
+    if (dst == a) {
+        pascal_string_append(dst, b);
+        return;
+    }
+    PascalString result = { NULL, 0, 0, { 0 } };
+    PascalString *target = dst == b ? &result : dst;
+    char *p = stringReserve(target, a->length + b->length, 0);
+    memcpy(p, stringChars(a), a->length);
+    memcpy(p + a->length, stringChars(b), b->length);
+    target->length = a->length + b->length;
+    if (target == &result)
+        pascal_string_move(dst, &result);
+}
+
+extern "C"
+long long pascal_string_compare(const PascalString *a, const PascalString *b)
+{
+    long long n = a->length < b->length ? a->length : b->length;
+    int order = n > 0 ? memcmp(stringChars(a), stringChars(b), n) : 0;
+    if (order == 0)
+        return a->length < b->length ? -1 : a->length > b->length;
+    return order < 0 ? -1 : 1;
+}
+
+extern "C"
+void pascal_string_from_int(PascalString *dst, long long val)
+{
+    char digits[MaxNumberChars];
+    long long n = std::to_chars(digits, digits + sizeof digits, val).ptr - digits;
+    memcpy(stringReserve(dst, n, 0), digits, n);
+    dst->length = n;
+}
+
+extern "C"
+void pascal_string_free(PascalString *s)
+{
+    stringClear(s);
+}
+
+/* Prints a string and a newline; strings longer than the buffer are
+   written directly */
+extern "C"
+void prints(const PascalString *s)
+{
+    size_t n = s->length;
+    outputReserve(output);
+    if (OutputBufferSize - output.used <= n) {
+        flushOutput(output);
+        if (n >= OutputBufferSize) {
+            writeAll(stringChars(s), n);
+            writeAll("\n", 1);
+            return;
+        }
+    }
+    memcpy(output.data + output.used, stringChars(s), n);
+    output.data[output.used + n] = '\n';
+    output.used += n + 1;
+}
+
+/* Standard input behind readi, readd, readarray and eof. When stdin is a
+   regular file it is mapped whole; otherwise it is read in large blocks,
+   and a number cut off at the end of a block is moved to the front before
+   the next read. Integers are parsed by hand, doubles with
+   std::from_chars. */
+static const size_t InputBufferSize = 1 << 20;
+static const size_t MaxTokenChars = 64; // numbers are never longer than this
+
+struct InputReader {
+    const char *pos;
+    const char *end;
+    char *buffer;     // NULL while nothing was read, or when stdin is mapped
+    void *map;
+    size_t mapSize;
+    bool started;
+    bool eof;         // everything left is between pos and end
+};
+
+static InputReader input = { NULL, NULL, NULL, NULL, 0, false, false };
+
+static void inputError(const char *message)
+{
+    flushOutput(output);
+    fprintf(stderr, "input error: %s\n", message);
+    exit(1);
+}
+
+static void inputStart(InputReader& in)
+{
+    in.started = true;
+    struct stat st;
+    off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode) && offset >= 0 && st.st_size > offset) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            in.map = map;
+            in.mapSize = st.st_size;
+            in.pos = (const char *)map + offset;
+            in.end = (const char *)map + st.st_size;
+            in.eof = true;
+            return;
+        }
+    }
+    in.buffer = (char *)malloc(InputBufferSize);
+    if (in.buffer == NULL)
+        outOfMemory(InputBufferSize);
+    in.pos = in.end = in.buffer;
+}
+
+/* Keeps what is left of the buffer and appends one read() */
+static void inputRead(InputReader& in)
+{
+    size_t left = in.end - in.pos;
+    memmove(in.buffer, in.pos, left);
+    in.pos = in.buffer;
+    in.end = in.buffer + left;
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, in.buffer + left, InputBufferSize - left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            in.eof = true;
+        else
+            in.end += n;
+        return;
+    }
+}
+
+/* Skips white space up to the next number and makes sure all of it is in
+   the buffer; false at the end of input */
+static bool inputNext(InputReader& in)
+{
+    if (!in.started)
+        inputStart(in);
+    for (;;) {
+        while (in.pos < in.end && (unsigned char)*in.pos <= ' ')
+            in.pos++;
+        if (in.eof || (size_t)(in.end - in.pos) >= MaxTokenChars)
+            return in.pos < in.end;
+        // 缓冲快用完时，数字后面要有空白才说明它是完整的
+        const char *p = in.pos;
+        while (p < in.end && (unsigned char)*p > ' ')
+            p++;
+        if (p < in.end)
+            return true;
+        inputRead(in);
+    }
+}
+
+static bool atSeparator(const InputReader& in, const char *p)
+{
+    return p == in.end || (unsigned char)*p <= ' ';
+}
+
+static long long readInt(InputReader& in)
+{
+    const char *p = in.pos;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        p++;
+    const char *digits = p;
+    unsigned long long value = 0;
+    while (p < in.end && (unsigned)(*p - '0') < 10) {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p == digits || !atSeparator(in, p))
+        inputError("expected an integer");
+    in.pos = p;
+    // 和整数运算一样按64位补码回绕
+    return (long long)(negative ? 0 - value : value);
+}
+
+static double readDouble(InputReader& in)
+{
+    const char *p = in.pos;
+    if (*p == '+')
+        p++;
+    double value;
+    std::from_chars_result result = std::from_chars(p, in.end, value);
+    if (result.ec != std::errc() || !atSeparator(in, result.ptr))
+        inputError("expected a number");
+    in.pos = result.ptr;
+    return value;
+}
+
+extern "C"
+long long readi()
+{
+    if (!inputNext(input))
+        inputError("unexpected end of input");
+    return readInt(input);
+}
+
+extern "C"
+double readd()
+{
+    if (!inputNext(input))
+        inputError("unexpected end of input");
+    return readDouble(input);
+}
+
+extern "C"
+long long eof()
+{
+    return !inputNext(input);
+}
+
+/* readarray: fill up to n elements, stopping early at the end of input;
+   return how many were read */
+extern "C"
+long long pascal_read_ints(long long *data, long long n)
+{
+    long long i = 0;
+    for (; i < n && inputNext(input); i++)
+        data[i] = readInt(input);
+    return i;
+}
+
+extern "C"
+long long pascal_read_doubles(double *data, long long n)
+{
+    long long i = 0;
+    for (; i < n && inputNext(input); i++)
+        data[i] = readDouble(input);
+    return i;
+}
+
+extern "C"
+void* pascal_alloc(long long bytes)
+{
+    void *p = calloc(1, bytes);
+    if (p == NULL)
+        outOfMemory(bytes);
+    return p;
+}
+
+extern "C"
+void pascal_free(void *p)
+{
+    free(p);
+}
+
+/* Bump allocators behind dynamic arrays. setlength on a local array takes
+   memory from the scope arena; a function marks it on entry and releases
+   everything allocated after the mark in one step when it returns. Arrays
+   that outlive the frame (globals, arrays passed by reference) grow in the
+   program arena instead, which is released once when main returns. */
+struct ArenaChunk {
+    ArenaChunk *prev;
+    size_t size;
+    size_t used;
+    size_t pad; // keeps the data that follows 16-byte aligned
+};
+
+struct Arena {
+    ArenaChunk *top;
+    ArenaChunk *spare; // last released chunk, reused before calling malloc
+};
+
+static const size_t ArenaChunkSize = 1 << 20;
+static Arena scopeArena = { NULL, NULL };
+static Arena programArena = { NULL, NULL };
+
+static char *chunkData(ArenaChunk *chunk)
+{
+    return (char *)(chunk + 1);
+}
+
+static void* arenaAlloc(Arena *arena, long long bytes)
+{
+    size_t n = ((size_t)bytes + 15) & ~(size_t)15;
+    if (arena->top == NULL || arena->top->size - arena->top->used < n) {
+        size_t size = n > ArenaChunkSize ? n : ArenaChunkSize;
+        ArenaChunk *chunk;
+        if (arena->spare != NULL && arena->spare->size >= size) {
+            chunk = arena->spare;
+            arena->spare = NULL;
+        }
+        else {
+            chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + size);
+            if (chunk == NULL)
+                outOfMemory(bytes);
+            chunk->size = size;
+        }
+        chunk->prev = arena->top;
+        chunk->used = 0;
+        arena->top = chunk;
+    }
+    char *p = chunkData(arena->top) + arena->top->used;
+    arena->top->used += n;
+    memset(p, 0, n);
+    return p;
+}
+
+static void arenaRelease(Arena *arena, void *mark)
+{
+    uintptr_t m = (uintptr_t)mark;
+    while (arena->top != NULL) {
+        uintptr_t data = (uintptr_t)chunkData(arena->top);
+        if (mark != NULL && m >= data && m <= data + arena->top->used) {
+            arena->top->used = m - data;
+            return;
+        }
+        ArenaChunk *chunk = arena->top;
+        arena->top = chunk->prev;
+        if (arena->spare == NULL || arena->spare->size < chunk->size) {
+            free(arena->spare);
+            arena->spare = chunk;
+        }
+        else {
+            free(chunk);
+        }
+    }
+}
+
+extern "C"
+void* pascal_arena_alloc(long long bytes)
+{
+    return arenaAlloc(&scopeArena, bytes);
+}
+
+extern "C"
+void* pascal_arena_mark()
+{
+    ArenaChunk *top = scopeArena.top;
+    return top == NULL ? NULL : chunkData(top) + top->used;
+}
+
+extern "C"
+void pascal_arena_release(void *mark)
+{
+    arenaRelease(&scopeArena, mark);
+}
+
+extern "C"
+void* pascal_static_alloc(long long bytes)
+{
+    return arenaAlloc(&programArena, bytes);
+}
+
+
+/* Files mapped behind file arrays. pascal_map_file fills the array's
+   {length, data} descriptor. Mappings are listed so they can be found again
+   by address: a function's local file arrays are unmapped when it returns,
+   and the rest when main returns. */
+struct ArrayDesc {
+    long long length;
+    void *data;
+};
+
+struct FileMapping {
+    FileMapping *next;
+    void *data;
+    size_t bytes;
+};
+
+static FileMapping *fileMappings = NULL;
+
+static void fileError(const char *path, const char *message)
+{
+    flushOutput(output);
+    fprintf(stderr, "file array %s: %s\n", path, message);
+    exit(1);
+}
+
+static void unmapFile(void *data)
+{
+    for (FileMapping **p = &fileMappings; *p != NULL; p = &(*p)->next) {
+        if ((*p)->data == data) {
+            FileMapping *mapping = *p;
+            *p = mapping->next;
+            munmap(mapping->data, mapping->bytes);
+            free(mapping);
+            return;
+        }
+    }
+}
+
+/* elements < 0 maps the whole file; readOnly maps it shared and read-only,
+   otherwise writes go to private copy-on-write pages */
+extern "C"
+void pascal_map_file(ArrayDesc *desc, const char *path, long long elementBytes, long long elements, long long readOnly, long long advice)
+{
+    unmapFile(desc->data);
+    desc->length = 0;
+    desc->data = NULL;
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        fileError(path, strerror(errno));
+    size_t available = (size_t)st.st_size / elementBytes;
+    if (elements < 0) {
+        elements = available;
+    }
+    else if ((size_t)elements > available) {
+        char message[100];
+        snprintf(message, sizeof(message), "holds %zu elements, %lld declared", available, elements);
+        fileError(path, message);
+    }
+    size_t bytes = (size_t)elements * elementBytes;
+    if (bytes > 0) {
+        void *data = mmap(NULL, bytes, readOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+                          readOnly ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+            fileError(path, strerror(errno));
+        if (advice != MADV_NORMAL)
+            madvise(data, bytes, advice);
+        FileMapping *mapping = (FileMapping *)malloc(sizeof(FileMapping));
+        if (mapping == NULL)
+            outOfMemory(sizeof(FileMapping));
+        mapping->next = fileMappings;
+        mapping->data = data;
+        mapping->bytes = bytes;
+        fileMappings = mapping;
+        desc->data = data;
+    }
+    desc->length = elements;
+    close(fd);
+}
+
+extern "C"
+void pascal_unmap_file(ArrayDesc *desc)
+{
+    unmapFile(desc->data);
+    desc->length = 0;
+    desc->data = NULL;
+}
+
+/* Open-addressed hash tables behind memo functions, one per function and
+   keyed on its argument tuple. Each slot holds nargs keys followed by the
+   value. Tables are created on the first store and released with the
+   program arena. */
+struct MemoTable {
+    MemoTable *next; // all tables, released together
+    void **owner;    // the function's table pointer
+    long long nargs;
+    size_t capacity; // power of two, kept at least twice count
+    size_t count;
+    long long *slots;
+    unsigned char *used;
+};
+
+static MemoTable *memoTables = NULL;
+
+static void *memoAlloc(size_t bytes)
+{
+    void *p = calloc(1, bytes);
+    if (p == NULL)
+        outOfMemory(bytes);
+    return p;
+}
+
+static size_t memoHash(long long nargs, const long long *key)
+{
+    uint64_t h = (uint64_t)nargs;
+    for (long long i = 0; i < nargs; i++) {
+        h = (h ^ (uint64_t)key[i]) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 32;
+    }
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return (size_t)h;
+}
+
+/* Slot holding key, or the empty slot where it belongs */
+static size_t memoFind(MemoTable *table, const long long *key)
+{
+    size_t mask = table->capacity - 1;
+    size_t stride = table->nargs + 1;
+    for (size_t i = memoHash(table->nargs, key) & mask; ; i = (i + 1) & mask) {
+        if (!table->used[i] || memcmp(table->slots + i * stride, key, table->nargs * sizeof(long long)) == 0)
+            return i;
+    }
+}
+
+static void memoResize(MemoTable *table, size_t capacity)
+{
+    size_t stride = table->nargs + 1;
+    long long *slots = table->slots;
+    unsigned char *used = table->used;
+    size_t old = table->capacity;
+    table->capacity = capacity;
+    table->slots = (long long *)memoAlloc(capacity * stride * sizeof(long long));
+    table->used = (unsigned char *)memoAlloc(capacity);
+    for (size_t i = 0; i < old; i++) {
+        if (!used[i])
+            continue;
+        size_t j = memoFind(table, slots + i * stride);
+        memcpy(table->slots + j * stride, slots + i * stride, stride * sizeof(long long));
+        table->used[j] = 1;
+    }
+    free(slots);
+    free(used);
+}
+
+extern "C"
+long long pascal_memo_lookup(void **table, long long nargs, const long long *key, long long *value)
+{
+    MemoTable *t = (MemoTable *)*table;
+    if (t == NULL)
+        return 0;
+    size_t i = memoFind(t, key);
+    if (!t->used[i])
+        return 0;
+    *value = t->slots[i * (nargs + 1) + nargs];
+    return 1;
+}
+
+extern "C"
+void pascal_memo_store(void **table, long long nargs, const long long *key, long long value)
+{
+    MemoTable *t = (MemoTable *)*table;
+    if (t == NULL) {
+        t = (MemoTable *)memoAlloc(sizeof(MemoTable));
+        t->owner = table;
+        t->nargs = nargs;
+        t->next = memoTables;
+        memoTables = t;
+        memoResize(t, 64);
+        *table = t;
+    }
+    else if (2 * (t->count + 1) > t->capacity) {
+        memoResize(t, 2 * t->capacity);
+    }
+    size_t i = memoFind(t, key);
+    long long *slot = t->slots + i * (nargs + 1);
+    if (!t->used[i]) {
+        memcpy(slot, key, nargs * sizeof(long long));
+        t->used[i] = 1;
+        t->count++;
+    }
+    slot[nargs] = value;
+}
+
+/* Writes out buffered output and frees the input, the mapped files, the
+   program arena and the memo tables when main returns */
+extern "C"
+void pascal_static_release()
+{
+    flushOutput(output);
+    free(output.data);
+    output.data = NULL;
+    if (input.map != NULL)
+        munmap(input.map, input.mapSize);
+    free(input.buffer);
+    input = InputReader();
+    while (fileMappings != NULL)
+        unmapFile(fileMappings->data);
+    arenaRelease(&programArena, NULL);
+    while (memoTables != NULL) {
+        MemoTable *table = memoTables;
+        memoTables = table->next;
+        *table->owner = NULL;
+        free(table->slots);
+        free(table->used);
+        free(table);
+    }
 }
@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include "node.h"
+
+AstArena astArena;
+
+const std::string& internName(std::string_view name)
+{
+	// 键是所指字符串的视图，查找不用先做一个std::string
+	static std::unordered_map<std::string_view, std::unique_ptr<std::string>> names;
+	auto found = names.find(name);
+	if (found != names.end())
+		return *found->second;
+	std::string *interned = new std::string(name);
+	names.emplace(*interned, std::unique_ptr<std::string>(interned));
+	return *interned;
+}
+
+static const size_t AstChunkBytes = 64 * 1024;
+static const size_t AstAlign = alignof(std::max_align_t);
+
+struct AstArena::Chunk {
+	Chunk *next;
+};
+
+/* Header in front of every object, linking them for release() */
+struct AstArena::Object {
+	Object *next;
+	void (*destroy)(void*);
+	// 头部补齐到对齐大小，对象本身仍然按max_align_t对齐
+	static const size_t Bytes = (sizeof(Object *) + sizeof(void (*)(void*)) + AstAlign - 1) & ~(AstAlign - 1);
+};
+
+void *AstArena::allocate(size_t bytes, void (*destroy)(void*))
+{
+	size_t size = (Object::Bytes + bytes + AstAlign - 1) & ~(AstAlign - 1);
+	if (next == NULL || (size_t)(end - next) < size) {
+		// 放不下就开新块，特别大的节点单独占一块
+		size_t chunkBytes = std::max(AstChunkBytes, size + AstAlign);
+		Chunk *chunk = (Chunk *)malloc(chunkBytes);
+		if (chunk == NULL)
+			throw std::bad_alloc();
+		chunk->next = chunks;
+		chunks = chunk;
+		next = (char *)chunk + AstAlign;
+		end = (char *)chunk + chunkBytes;
+	}
+	Object *object = (Object *)next;
+	object->next = objects;
+	object->destroy = destroy;
+	objects = object;
+	next += size;
+	return (char *)object + Object::Bytes;
+}
+
+void AstArena::release(const Mark& mark)
+{
+	while (objects != mark.objects) {
+		Object *object = objects;
+		objects = object->next;
+		object->destroy((char *)object + Object::Bytes);
+	}
+	// mark之后开的块整块释放，mark所在的块退回到mark的位置
+	while (chunks != mark.chunks) {
+		Chunk *chunk = chunks;
+		chunks = chunk->next;
+		free(chunk);
+	}
+	next = mark.next;
+	end = mark.end;
+	children.resize(mark.children);
+}
+
+void AstArena::release()
+{
+	// 节点之间只有引用，析构时不会碰到别的节点，顺序无所谓
+	release(Mark{ NULL, NULL, NULL, NULL, 0 });
+	children.shrink_to_fit();
+}
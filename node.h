@@ -1,8 +1,13 @@
 #include <iostream>
 #include <vector>
+#include <new>
+#include <utility>
+#include <cstdint>
+#include <string_view>
 #include <llvm/IR/Value.h>
 
 class CodeGenContext;
+class Node;
 class NStatement;
 class NExpression;
 class NVariableDeclaration;
@@ -15,48 +20,163 @@ typedef std::vector<NStatement*> StatementList;
 typedef std::vector<NExpression*> ExpressionList;
 typedef std::vector<NVariableDeclaration*> VariableList;
 typedef std::vector<NIdentifier *> IdentifierList;
+typedef std::vector<std::string> PragmaList;
+
+/* Bump allocator for one compilation's AST: the nodes (see Node::operator
+   new), the lists the parser builds them from and the children array the
+   nodes' child ranges index (see NodeRange). Nothing is freed one by one;
+   release() runs every destructor, newest first, and then frees the memory
+   in one pass, see node.cpp. release(mark) does the same for what was
+   allocated after mark, which the streaming parser uses to drop each
+   top-level statement once it is compiled. */
+class AstArena {
+	struct Chunk;
+	struct Object;
+	Chunk *chunks;
+	Object *objects;
+	char *next, *end;
+	template <class T> static void destroy(void *object) { static_cast<T*>(object)->~T(); }
+public:
+	std::vector<Node*> children;
+	AstArena() : chunks(NULL), objects(NULL), next(NULL), end(NULL) { }
+	~AstArena() { release(); }
+	/* Position to roll back to: release(mark) frees what came after it */
+	struct Mark {
+		Object *objects;
+		Chunk *chunks;
+		char *next, *end;
+		size_t children;
+	};
+	Mark mark() const { return Mark{ objects, chunks, next, end, children.size() }; }
+	void *allocate(size_t bytes, void (*destroy)(void*));
+	void release();
+	void release(const Mark& mark);
+	template <class T, class... Args> T *make(Args&&... args) {
+		return new (allocate(sizeof(T), destroy<T>)) T(std::forward<Args>(args)...);
+	}
+};
+
+extern AstArena astArena;
+
+/* The one copy of a name shared by every identifier spelled that way. Names
+   outlive the arena: a program has few distinct ones and later
+   compilations of the same source reuse them. */
+const std::string& internName(std::string_view name);
+
+/* What a node is, for walking the tree with a switch and for llvm::isa,
+   dyn_cast and cast, which work on nodes through the classof of each
+   class. Expressions come first, then statements. */
+enum NodeKind {
+	NODE_INTEGER, NODE_DOUBLE, NODE_STRING, NODE_IDENTIFIER, NODE_METHOD_CALL,
+	NODE_BINARY_OPERATOR, NODE_ARRAY_ASSIGNMENT, NODE_FIELD_REF, NODE_FIELD_ASSIGNMENT,
+	NODE_ASSIGNMENT, NODE_BLOCK, NODE_ARRAY_REF,
+	NODE_EXPRESSION_STATEMENT, NODE_RETURN, NODE_VARIABLE_DECLARATION, NODE_ARRAY_PARAMETER,
+	NODE_EXTERN_DECLARATION, NODE_FUNCTION_DECLARATION, NODE_CONST_DECLARATION,
+	NODE_VARIABLE_DECLARATIONS, NODE_IF, NODE_ARRAY_DECLARATION, NODE_ARRAY_DECLARATIONS,
+	NODE_RECORD_DECLARATION, NODE_FOR, NODE_FOREACH
+};
 
 class Node {
 public:
+	const NodeKind kind;
+	Node(NodeKind kind) : kind(kind) { }
 	virtual ~Node() {}
 	virtual llvm::Value* codeGen(CodeGenContext& context) { return NULL; }
+	// new的节点都在astArena里，随它一起释放；栈上的节点照常析构
+	static void *operator new(size_t bytes) { return astArena.allocate(bytes, destroy); }
+	static void operator delete(void *node) { }
+private:
+	static void destroy(void *node) { static_cast<Node*>(node)->~Node(); }
 };
 
 class NExpression : public Node {
+public:
+	NExpression(NodeKind kind) : Node(kind) { }
+	static bool classof(const Node *node) { return node->kind < NODE_EXPRESSION_STATEMENT; }
 };
 
 class NStatement : public Node {
+public:
+	NStatement(NodeKind kind) : Node(kind) { }
+	static bool classof(const Node *node) { return node->kind >= NODE_EXPRESSION_STATEMENT; }
+};
+
+/* Children of a node: count entries of astArena.children from first on.
+   The parser collects them in a list and the node copies the list to the
+   end of the array once it is complete, so the children of a node lie
+   next to each other and a node holds two indices instead of a vector. */
+template <class T>
+class NodeRange {
+	uint32_t first, count;
+public:
+	class iterator {
+		size_t at;
+	public:
+		iterator(size_t at) : at(at) { }
+		T *operator*() const { return static_cast<T*>(astArena.children[at]); }
+		iterator& operator++() { at++; return *this; }
+		iterator operator++(int) { return iterator(at++); }
+		bool operator==(const iterator& other) const { return at == other.at; }
+		bool operator!=(const iterator& other) const { return at != other.at; }
+	};
+	typedef iterator const_iterator;
+	NodeRange() : first(0), count(0) { }
+	NodeRange(const std::vector<T*>& list) : first(astArena.children.size()), count(list.size()) {
+		astArena.children.insert(astArena.children.end(), list.begin(), list.end());
+	}
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	T *operator[](size_t i) const { return static_cast<T*>(astArena.children[first + i]); }
+	T *back() const { return (*this)[count - 1]; }
+	iterator begin() const { return iterator(first); }
+	iterator end() const { return iterator(first + count); }
 };
 
+typedef NodeRange<NStatement> StatementRange;
+typedef NodeRange<NExpression> ExpressionRange;
+
 class NInteger : public NExpression {
 public:
 	long long value;
-	NInteger(long long value) : value(value) { }
+	NInteger(long long value) : NExpression(NODE_INTEGER), value(value) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_INTEGER; }
 };
 
 class NDouble : public NExpression {
 public:
 	double value;
-	NDouble(double value) : value(value) { }
+	NDouble(double value) : NExpression(NODE_DOUBLE), value(value) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_DOUBLE; }
+};
+
+class NString : public NExpression {
+public:
+	std::string value;
+	NString(const std::string& value) : NExpression(NODE_STRING), value(value) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_STRING; }
 };
 
 class NIdentifier : public NExpression {
 public:
-	std::string name;
-	NIdentifier(const std::string& name) : name(name) { }
+	const std::string& name;
+	NIdentifier(const std::string& name) : NExpression(NODE_IDENTIFIER), name(internName(name)) { }
+	NIdentifier(const std::string *interned) : NExpression(NODE_IDENTIFIER), name(*interned) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_IDENTIFIER; }
 };
 
 class NMethodCall : public NExpression {
 public:
 	const NIdentifier& id;
-	ExpressionList arguments;
-	NMethodCall(const NIdentifier& id, ExpressionList& arguments) :
-		id(id), arguments(arguments) { }
-	NMethodCall(const NIdentifier& id) : id(id) { }
+	ExpressionRange arguments;
+	NMethodCall(const NIdentifier& id, const ExpressionList& arguments) :
+		NExpression(NODE_METHOD_CALL), id(id), arguments(arguments) { }
+	NMethodCall(const NIdentifier& id) : NExpression(NODE_METHOD_CALL), id(id) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_METHOD_CALL; }
 };
 
 class NBinaryOperator : public NExpression {
@@ -65,69 +185,120 @@ public:
 	NExpression& lhs;
 	NExpression& rhs;
 	NBinaryOperator(NExpression& lhs, int op, NExpression& rhs) :
-		lhs(lhs), rhs(rhs), op(op) { }
+		NExpression(NODE_BINARY_OPERATOR), lhs(lhs), rhs(rhs), op(op) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_BINARY_OPERATOR; }
 };
 
 class NArrayAssignment : public NExpression {
 	public:
 		NIdentifier& lhs;
-		NExpression& index;
+		ExpressionRange indices;
 		NExpression& rhs;
-		NArrayAssignment(NIdentifier&lhs, NExpression& index, NExpression& rhs): 
-			lhs(lhs), index(index), rhs(rhs) { }
+		NArrayAssignment(NIdentifier&lhs, const ExpressionList& indices, NExpression& rhs):
+			NExpression(NODE_ARRAY_ASSIGNMENT), lhs(lhs), indices(indices), rhs(rhs) { }
 		virtual llvm::Value* codeGen(CodeGenContext& context);
+		static bool classof(const Node *node) { return node->kind == NODE_ARRAY_ASSIGNMENT; }
+};
+/* p.f or a[i, ...].f on records */
+class NFieldRef : public NExpression {
+public:
+	NIdentifier& id;
+	ExpressionRange indices;
+	NIdentifier& field;
+	NFieldRef(NIdentifier& id, NIdentifier& field) : NExpression(NODE_FIELD_REF), id(id), field(field) { }
+	NFieldRef(NIdentifier& id, const ExpressionList& indices, NIdentifier& field) :
+		NExpression(NODE_FIELD_REF), id(id), indices(indices), field(field) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_FIELD_REF; }
+};
+
+class NFieldAssignment : public NExpression {
+public:
+	NIdentifier& id;
+	ExpressionRange indices;
+	NIdentifier& field;
+	NExpression& rhs;
+	NFieldAssignment(NIdentifier& id, NIdentifier& field, NExpression& rhs) :
+		NExpression(NODE_FIELD_ASSIGNMENT), id(id), field(field), rhs(rhs) { }
+	NFieldAssignment(NIdentifier& id, const ExpressionList& indices, NIdentifier& field, NExpression& rhs) :
+		NExpression(NODE_FIELD_ASSIGNMENT), id(id), indices(indices), field(field), rhs(rhs) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_FIELD_ASSIGNMENT; }
 };
+
 class NAssignment : public NExpression {
 public:
 	NIdentifier& lhs;
 	NExpression& rhs;
-	NAssignment(NIdentifier& lhs, NExpression& rhs) : 
-		lhs(lhs), rhs(rhs) { }
+	NAssignment(NIdentifier& lhs, NExpression& rhs) :
+		NExpression(NODE_ASSIGNMENT), lhs(lhs), rhs(rhs) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_ASSIGNMENT; }
 };
 
 class NBlock : public NExpression {
 public:
-	StatementList statements;
-	NBlock() { }
+	StatementRange statements;
+	NBlock() : NExpression(NODE_BLOCK) { }
+	NBlock(const StatementList& statements) : NExpression(NODE_BLOCK), statements(statements) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_BLOCK; }
 };
 
+/* a[i] or a[i, j, ...], one index per dimension */
 class NArrayRef : public NExpression {
 public:
 	NIdentifier& id;
-	NExpression& index;
-	NArrayRef(NIdentifier& id, NExpression& index) : id(id), index(index) { }
+	ExpressionRange indices;
+	NArrayRef(NIdentifier& id, const ExpressionList& indices) : NExpression(NODE_ARRAY_REF), id(id), indices(indices) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_ARRAY_REF; }
 };
 
 class NExpressionStatement : public NStatement {
 public:
 	NExpression& expression;
-	NExpressionStatement(NExpression& expression) : 
-		expression(expression) { }
+	NExpressionStatement(NExpression& expression) :
+		NStatement(NODE_EXPRESSION_STATEMENT), expression(expression) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_EXPRESSION_STATEMENT; }
 };
 
 class NReturnStatement : public NStatement {
 public:
 	NExpression& expression;
-	NReturnStatement(NExpression& expression) : 
-		expression(expression) { }
+	NReturnStatement(NExpression& expression) :
+		NStatement(NODE_RETURN), expression(expression) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_RETURN; }
 };
 
+/* How a parameter is passed: scalars always by value (const ones are read
+   only), var and const arrays by reference */
+enum ParamMode { PARAM_VALUE, PARAM_VAR, PARAM_CONST };
+
 class NVariableDeclaration : public NStatement {
 public:
 	const NIdentifier& type;
 	NIdentifier& id;
 	NExpression *assignmentExpr;
-	NVariableDeclaration(const NIdentifier& type, NIdentifier& id) :
-		type(type), id(id) { assignmentExpr = NULL; }
+	int mode;
+	NVariableDeclaration(const NIdentifier& type, NIdentifier& id, NodeKind kind = NODE_VARIABLE_DECLARATION) :
+		NStatement(kind), type(type), id(id), mode(PARAM_VALUE) { assignmentExpr = NULL; }
 	NVariableDeclaration(const NIdentifier& type, NIdentifier& id, NExpression *assignmentExpr) :
-		type(type), id(id), assignmentExpr(assignmentExpr) { }
+		NStatement(NODE_VARIABLE_DECLARATION), type(type), id(id), assignmentExpr(assignmentExpr), mode(PARAM_VALUE) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_VARIABLE_DECLARATION || node->kind == NODE_ARRAY_PARAMETER; }
+};
+
+/* var/const a: array[R, ...] of T, or array of T when dims is empty */
+class NArrayParameter : public NVariableDeclaration {
+public:
+	ExpressionRange dims;
+	NArrayParameter(const NIdentifier& type, NIdentifier& id, const ExpressionRange& dims, int mode) :
+		NVariableDeclaration(type, id, NODE_ARRAY_PARAMETER), dims(dims) { this->mode = mode; }
+	static bool classof(const Node *node) { return node->kind == NODE_ARRAY_PARAMETER; }
 };
 
 class NExternDeclaration : public NStatement {
@@ -137,32 +308,50 @@ public:
     VariableList arguments;
     NExternDeclaration(const NIdentifier& type, const NIdentifier& id,
             const VariableList& arguments) :
-        type(type), id(id), arguments(arguments) {}
+        NStatement(NODE_EXTERN_DECLARATION), type(type), id(id), arguments(arguments) {}
     virtual llvm::Value* codeGen(CodeGenContext& context);
+    static bool classof(const Node *node) { return node->kind == NODE_EXTERN_DECLARATION; }
 };
 
+/* function f(args): T [inline|noinline|pure|hot|cold ...] begin ... end; */
 class NFunctionDeclaration : public NStatement {
 public:
 	const NIdentifier& type;
 	const NIdentifier& id;
 	VariableList arguments;
 	NBlock& block;
+	std::vector<std::string> directives;
 	NFunctionDeclaration(const NIdentifier& type, const NIdentifier& id, 
 			const VariableList& arguments, NBlock& block) :
-		type(type), id(id), arguments(arguments), block(block) { }
+		NStatement(NODE_FUNCTION_DECLARATION), type(type), id(id), arguments(arguments), block(block) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_FUNCTION_DECLARATION; }
+};
+
+/* const N = 1000; K = N * 4 -- evaluated at compile time. Definitions
+   after the first leave out the keyword and are marked continued. */
+class NConstDeclaration : public NStatement {
+public:
+	NIdentifier& id;
+	NExpression& value;
+	bool continued;
+	NConstDeclaration(NIdentifier& id, NExpression& value) :
+		NStatement(NODE_CONST_DECLARATION), id(id), value(value), continued(false) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_CONST_DECLARATION; }
 };
 
 class NVariableDeclarationS : public NStatement {
 public:
 	std::vector<NVariableDeclaration *>VariableDeclarationList;
 	NExpression *assignmentExpr;
-	NVariableDeclarationS()  { assignmentExpr = NULL; }
+	NVariableDeclarationS() : NStatement(NODE_VARIABLE_DECLARATIONS)  { assignmentExpr = NULL; }
 	NVariableDeclarationS( std::vector<NVariableDeclaration *>VariableDeclarationList) :
-		 VariableDeclarationList(VariableDeclarationList) { assignmentExpr = NULL; }
+		 NStatement(NODE_VARIABLE_DECLARATIONS), VariableDeclarationList(VariableDeclarationList) { assignmentExpr = NULL; }
 	NVariableDeclarationS( std::vector<NVariableDeclaration *>VariableDeclarationList, NExpression *assignmentExpr) :
-		 VariableDeclarationList(VariableDeclarationList), assignmentExpr(assignmentExpr) { }
+		 NStatement(NODE_VARIABLE_DECLARATIONS), VariableDeclarationList(VariableDeclarationList), assignmentExpr(assignmentExpr) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_VARIABLE_DECLARATIONS; }
 };
 
 class NIFStatement : public NStatement {
@@ -172,38 +361,76 @@ public:
     NExpression& elseStatement;
 
     NIFStatement(NExpression& condition, NExpression& ifStatement, NExpression& elseStatement)
-        : condition(condition), ifStatement(ifStatement), elseStatement(elseStatement) {}
+        : NStatement(NODE_IF), condition(condition), ifStatement(ifStatement), elseStatement(elseStatement) {}
 
     virtual llvm::Value* codeGen(CodeGenContext& context);
+    static bool classof(const Node *node) { return node->kind == NODE_IF; }
 };
 
+/* var a: array[R, C, ...] of T [= (v1, v2, ...)], stored row-major, the
+   initializer listing elements in that order; {$soa} in front of an array
+   of records stores each field in its own array. With no dims it is
+   var a: array of T, sized at run time with setlength. */
 class NArrayDeclaration : public NStatement {
 public:
 	const NIdentifier& type;
 	const NIdentifier& id;
-	const NInteger& sz;
-	NArrayDeclaration(const NIdentifier& type, const NIdentifier& id, const NInteger& sz) :
-		type(type), id(id), sz(sz) { }
+	ExpressionRange dims;
+	ExpressionRange initializer; // empty: zero-initialized
+	std::string file; // file array: the file mapped into memory
+	PragmaList pragmas;
+	NArrayDeclaration(const NIdentifier& type, const NIdentifier& id, const ExpressionRange& dims) :
+		NStatement(NODE_ARRAY_DECLARATION), type(type), id(id), dims(dims) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_ARRAY_DECLARATION; }
+};
+
+class NArrayDeclarationS : public NStatement {
+public:
+	std::vector<NArrayDeclaration *> ArrayDeclarationList;
+	NArrayDeclarationS() : NStatement(NODE_ARRAY_DECLARATIONS) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_ARRAY_DECLARATIONS; }
+};
+
+/* type T = record f1, f2: T1; f3: T2 end */
+class NRecordDeclaration : public NStatement {
+public:
+	const NIdentifier& id;
+	VariableList fields;
+	NRecordDeclaration(const NIdentifier& id, const VariableList& fields) :
+		NStatement(NODE_RECORD_DECLARATION), id(id), fields(fields) { }
+	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_RECORD_DECLARATION; }
+};
+
+/* for/foreach loops, with the {$...} directives written in front of them */
+class NLoopStatement : public NStatement {
+public:
+	PragmaList pragmas;
+	NLoopStatement(NodeKind kind) : NStatement(kind) { }
+	static bool classof(const Node *node) { return node->kind == NODE_FOR || node->kind == NODE_FOREACH; }
 };
 
-class FORStatement : public NStatement {
+class FORStatement : public NLoopStatement {
 public:
 	NIdentifier& iter;
 	NExpression& condition_start;
 	NExpression& condition_end;
 	NExpression& for_block;
 	FORStatement(NIdentifier& iter,NExpression& condition_start, NExpression& condition_end,NExpression& for_block):
-		iter(iter),condition_start(condition_start), condition_end(condition_end),for_block(for_block) { }
+		NLoopStatement(NODE_FOR), iter(iter),condition_start(condition_start), condition_end(condition_end),for_block(for_block) { }
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_FOR; }
 };
 
-class FOREACHStatement : public NStatement {
+class FOREACHStatement : public NLoopStatement {
 public:
 	NIdentifier& iter;
 	NIdentifier& id;
 	NExpression& for_block;
 	FOREACHStatement(NIdentifier& iter, NIdentifier& id, NExpression& for_block):
-		iter(iter), id(id), for_block(for_block) {}
+		NLoopStatement(NODE_FOREACH), iter(iter), id(id), for_block(for_block) {}
 	virtual llvm::Value* codeGen(CodeGenContext& context);
+	static bool classof(const Node *node) { return node->kind == NODE_FOREACH; }
 };
\ No newline at end of file
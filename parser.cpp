@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.4.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -33,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,11 +45,11 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.0.4"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
@@ -61,10 +66,11 @@
 
 
 
-/* Copy the first part of user declarations.  */
-#line 1 "parser.y" /* yacc.c:339  */
+/* First part of user prologue.  */
+#line 1 "parser.y"
 
 	#include "node.h"
+	#include "codegen.h"
         #include <cstdio>
         #include <cstdlib>
 	#include<vector>
@@ -73,155 +79,243 @@
 
 	extern int yylex();
 	void yyerror(const char *s) { std::printf("Error: %s\n", s);std::exit(1); }
-
-#line 78 "parser.cpp" /* yacc.c:339  */
-
+	/* K = N * 4 without the keyword only continues a const section */
+	static void checkConstSection(bool afterConst, NStatement *stmt) {
+		NConstDeclaration *def = llvm::dyn_cast<NConstDeclaration>(stmt);
+		if (def != NULL && def->continued && !afterConst)
+			yyerror("constant definition outside a const section");
+	}
+	static bool endsWithConst(StatementList *statements) {
+		return !statements->empty() && llvm::isa<NConstDeclaration>(statements->back());
+	}
+
+	/* Streaming: with a context set by startStreaming, every top-level
+	   statement is compiled as soon as it is reduced and its tree is freed
+	   (back to the arena mark taken after the previous one), so only the
+	   main block is kept until the end */
+	static CodeGenContext *streamContext = NULL;
+	static AstArena::Mark streamMark;
+	static bool streamAfterConst = false;
+
+	void startStreaming(CodeGenContext& context) {
+		streamContext = &context;
+		streamMark = astArena.mark();
+	}
+
+	static StatementList *topLevel(StatementList *statements, NStatement *stmt) {
+		if (streamContext == NULL) {
+			if (statements == NULL)
+				statements = astArena.make<StatementList>();
+			checkConstSection(endsWithConst(statements), stmt);
+			statements->push_back(stmt);
+			return statements;
+		}
+		checkConstSection(streamAfterConst, stmt);
+		streamAfterConst = llvm::isa<NConstDeclaration>(stmt);
+		if (streamContext->generateTopLevel(*stmt))
+			astArena.release(streamMark);
+		streamMark = astArena.mark();
+		return NULL;
+	}
+
+#line 122 "parser.cpp"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
 # ifndef YY_NULLPTR
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULLPTR nullptr
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
 #  else
-#   define YY_NULLPTR 0
+#   define YY_NULLPTR ((void*)0)
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* In a future release of Bison, this section will be replaced
-   by #include "parser.hpp".  */
-#ifndef YY_YY_PARSER_HPP_INCLUDED
-# define YY_YY_PARSER_HPP_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 0
-#endif
-#if YYDEBUG
-extern int yydebug;
-#endif
-
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    TIDENTIFIER = 258,
-    TINTEGER = 259,
-    TDOUBLE = 260,
-    TCEQ = 261,
-    TCNE = 262,
-    TCLT = 263,
-    TCLE = 264,
-    TCGT = 265,
-    TCGE = 266,
-    TEQUAL = 267,
-    TLPAREN = 268,
-    TRPAREN = 269,
-    TLBRACE = 270,
-    TRBRACE = 271,
-    TCOMMA = 272,
-    TDOT = 273,
-    SQLBRACE = 274,
-    SQRBRACE = 275,
-    TPLUS = 276,
-    TMINUS = 277,
-    TMUL = 278,
-    TDIV = 279,
-    TRETURN = 280,
-    TEXTERN = 281,
-    VAR = 282,
-    COLON = 283,
-    FUNCTION = 284,
-    SEMICOLON = 285,
-    PROGRAM = 286,
-    IF = 287,
-    ELSE = 288,
-    THEN = 289,
-    TBEGIN = 290,
-    TEND = 291,
-    TDO = 292,
-    TFOR = 293,
-    TTO = 294,
-    ARRAY = 295,
-    OF = 296,
-    TFOREACH = 297,
-    IN = 298
-  };
-#endif
-
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-
-union YYSTYPE
+#include "parser.hpp"
+/* Symbol kind.  */
+enum yysymbol_kind_t
 {
-#line 14 "parser.y" /* yacc.c:355  */
-
-	Node *node;
-	NBlock *block;
-	NExpression *expr;
-	NStatement *stmt;
-	NIdentifier *ident;
-	NVariableDeclaration *var_decl;
-	NVariableDeclarationS *varlist_decl;
-	NFunctionDeclaration *func_decl;
-	NArrayDeclaration *array_decl;
-	std::vector<NVariableDeclaration*> *varvec;
-	std::vector<NVariableDeclarationS*> *varlistvec;
-	std::vector<NExpression*> *exprvec;
-	std::vector<std::string> *stringvec;
-	std::vector<NIdentifier *> *identlist;
-	std::string *string;
-	int token;
-
-#line 181 "parser.cpp" /* yacc.c:355  */
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_TIDENTIFIER = 3,                /* TIDENTIFIER  */
+  YYSYMBOL_TPRAGMA = 4,                    /* TPRAGMA  */
+  YYSYMBOL_TINTEGER = 5,                   /* TINTEGER  */
+  YYSYMBOL_TDOUBLE = 6,                    /* TDOUBLE  */
+  YYSYMBOL_TSTRING = 7,                    /* TSTRING  */
+  YYSYMBOL_TCEQ = 8,                       /* TCEQ  */
+  YYSYMBOL_TCNE = 9,                       /* TCNE  */
+  YYSYMBOL_TCLT = 10,                      /* TCLT  */
+  YYSYMBOL_TCLE = 11,                      /* TCLE  */
+  YYSYMBOL_TCGT = 12,                      /* TCGT  */
+  YYSYMBOL_TCGE = 13,                      /* TCGE  */
+  YYSYMBOL_TEQUAL = 14,                    /* TEQUAL  */
+  YYSYMBOL_TLPAREN = 15,                   /* TLPAREN  */
+  YYSYMBOL_TRPAREN = 16,                   /* TRPAREN  */
+  YYSYMBOL_TLBRACE = 17,                   /* TLBRACE  */
+  YYSYMBOL_TRBRACE = 18,                   /* TRBRACE  */
+  YYSYMBOL_TCOMMA = 19,                    /* TCOMMA  */
+  YYSYMBOL_TDOT = 20,                      /* TDOT  */
+  YYSYMBOL_SQLBRACE = 21,                  /* SQLBRACE  */
+  YYSYMBOL_SQRBRACE = 22,                  /* SQRBRACE  */
+  YYSYMBOL_TPLUS = 23,                     /* TPLUS  */
+  YYSYMBOL_TMINUS = 24,                    /* TMINUS  */
+  YYSYMBOL_TMUL = 25,                      /* TMUL  */
+  YYSYMBOL_TDIV = 26,                      /* TDIV  */
+  YYSYMBOL_TRETURN = 27,                   /* TRETURN  */
+  YYSYMBOL_TEXTERN = 28,                   /* TEXTERN  */
+  YYSYMBOL_VAR = 29,                       /* VAR  */
+  YYSYMBOL_COLON = 30,                     /* COLON  */
+  YYSYMBOL_FUNCTION = 31,                  /* FUNCTION  */
+  YYSYMBOL_SEMICOLON = 32,                 /* SEMICOLON  */
+  YYSYMBOL_PROGRAM = 33,                   /* PROGRAM  */
+  YYSYMBOL_IF = 34,                        /* IF  */
+  YYSYMBOL_ELSE = 35,                      /* ELSE  */
+  YYSYMBOL_THEN = 36,                      /* THEN  */
+  YYSYMBOL_TBEGIN = 37,                    /* TBEGIN  */
+  YYSYMBOL_TEND = 38,                      /* TEND  */
+  YYSYMBOL_TDO = 39,                       /* TDO  */
+  YYSYMBOL_TFOR = 40,                      /* TFOR  */
+  YYSYMBOL_TTO = 41,                       /* TTO  */
+  YYSYMBOL_ARRAY = 42,                     /* ARRAY  */
+  YYSYMBOL_OF = 43,                        /* OF  */
+  YYSYMBOL_TFOREACH = 44,                  /* TFOREACH  */
+  YYSYMBOL_IN = 45,                        /* IN  */
+  YYSYMBOL_TTYPE = 46,                     /* TTYPE  */
+  YYSYMBOL_TRECORD = 47,                   /* TRECORD  */
+  YYSYMBOL_TCONST = 48,                    /* TCONST  */
+  YYSYMBOL_TFILE = 49,                     /* TFILE  */
+  YYSYMBOL_YYACCEPT = 50,                  /* $accept  */
+  YYSYMBOL_program = 51,                   /* program  */
+  YYSYMBOL_main_stmt = 52,                 /* main_stmt  */
+  YYSYMBOL_decls = 53,                     /* decls  */
+  YYSYMBOL_stmts = 54,                     /* stmts  */
+  YYSYMBOL_expr_block = 55,                /* expr_block  */
+  YYSYMBOL_array_decl = 56,                /* array_decl  */
+  YYSYMBOL_dim_list = 57,                  /* dim_list  */
+  YYSYMBOL_const_def = 58,                 /* const_def  */
+  YYSYMBOL_record_decl = 59,               /* record_decl  */
+  YYSYMBOL_field_list = 60,                /* field_list  */
+  YYSYMBOL_field = 61,                     /* field  */
+  YYSYMBOL_stmt = 62,                      /* stmt  */
+  YYSYMBOL_loop_stmt = 63,                 /* loop_stmt  */
+  YYSYMBOL_block = 64,                     /* block  */
+  YYSYMBOL_var_decl = 65,                  /* var_decl  */
+  YYSYMBOL_idlist = 66,                    /* idlist  */
+  YYSYMBOL_extern_decl = 67,               /* extern_decl  */
+  YYSYMBOL_func_decl = 68,                 /* func_decl  */
+  YYSYMBOL_directives = 69,                /* directives  */
+  YYSYMBOL_func_decl_args = 70,            /* func_decl_args  */
+  YYSYMBOL_param_decl = 71,                /* param_decl  */
+  YYSYMBOL_ident = 72,                     /* ident  */
+  YYSYMBOL_numeric = 73,                   /* numeric  */
+  YYSYMBOL_expr = 74,                      /* expr  */
+  YYSYMBOL_assign_rhs = 75,                /* assign_rhs  */
+  YYSYMBOL_call_args = 76,                 /* call_args  */
+  YYSYMBOL_index_list = 77,                /* index_list  */
+  YYSYMBOL_comparison = 78                 /* comparison  */
 };
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-typedef union YYSTYPE YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
 
 
-extern YYSTYPE yylval;
 
-int yyparse (void);
+#ifdef short
+# undef short
+#endif
 
-#endif /* !YY_YY_PARSER_HPP_INCLUDED  */
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
 
-/* Copy the second part of user declarations.  */
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
 
-#line 198 "parser.cpp" /* yacc.c:358  */
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
 
-#ifdef short
-# undef short
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
 #else
-typedef unsigned char yytype_uint8;
+typedef short yytype_int16;
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
-#else
-typedef signed char yytype_int8;
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -229,15 +323,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_uint8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -251,47 +358,43 @@ typedef short int yytype_int16;
 # endif
 #endif
 
-#ifndef YY_ATTRIBUTE
-# if (defined __GNUC__                                               \
-      && (2 < __GNUC__ || (__GNUC__ == 2 && 96 <= __GNUC_MINOR__)))  \
-     || defined __SUNPRO_C && 0x5110 <= __SUNPRO_C
-#  define YY_ATTRIBUTE(Spec) __attribute__(Spec)
-# else
-#  define YY_ATTRIBUTE(Spec) /* empty */
-# endif
-#endif
 
 #ifndef YY_ATTRIBUTE_PURE
-# define YY_ATTRIBUTE_PURE   YY_ATTRIBUTE ((__pure__))
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
 #endif
 
 #ifndef YY_ATTRIBUTE_UNUSED
-# define YY_ATTRIBUTE_UNUSED YY_ATTRIBUTE ((__unused__))
-#endif
-
-#if !defined _Noreturn \
-     && (!defined __STDC_VERSION__ || __STDC_VERSION__ < 201112)
-# if defined _MSC_VER && 1200 <= _MSC_VER
-#  define _Noreturn __declspec (noreturn)
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
 # else
-#  define _Noreturn YY_ATTRIBUTE ((__noreturn__))
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -304,8 +407,22 @@ typedef short int yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -370,8 +487,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -380,17 +496,17 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -403,11 +519,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -419,12 +535,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -434,30 +550,33 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  31
+#define YYFINAL  45
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   264
+#define YYLAST   416
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  44
+#define YYNTOKENS  50
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  18
+#define YYNNTS  29
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  52
+#define YYNRULES  90
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  116
+#define YYNSTATES  201
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   304
 
-/* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
-   by yylex, with out-of-bounds checking.  */
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   298
 
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
-   as returned by yylex, without out-of-bounds checking.  */
-static const yytype_uint8 yytranslate[] =
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -488,252 +607,328 @@ static const yytype_uint8 yytranslate[] =
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
       15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
       25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
-      35,    36,    37,    38,    39,    40,    41,    42,    43
+      35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
+      45,    46,    47,    48,    49
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_uint8 yyrline[] =
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
 {
-       0,    67,    67,    77,    79,    80,    83,    84,    87,    90,
-      90,    90,    90,    91,    92,    93,    94,    95,    96,    99,
-     100,   103,   111,   112,   114,   118,   125,   126,   132,   139,
-     142,   143,   146,   147,   148,   149,   150,   151,   152,   153,
-     154,   155,   156,   157,   160,   161,   162,   165,   165,   165,
-     165,   165,   165
+       0,   119,   119,   135,   137,   138,   141,   142,   145,   146,
+     149,   156,   164,   170,   179,   187,   196,   197,   200,   201,
+     204,   207,   208,   211,   217,   220,   220,   220,   220,   221,
+     222,   223,   224,   225,   226,   227,   228,   231,   232,   233,
+     236,   237,   240,   248,   249,   251,   255,   262,   263,   264,
+     267,   268,   269,   272,   278,   285,   292,   299,   305,   313,
+     316,   317,   320,   321,   322,   323,   324,   325,   326,   327,
+     328,   329,   330,   331,   332,   333,   334,   335,   336,   341,
+     344,   345,   346,   349,   350,   353,   353,   353,   353,   353,
+     353
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "TIDENTIFIER", "TINTEGER", "TDOUBLE",
-  "TCEQ", "TCNE", "TCLT", "TCLE", "TCGT", "TCGE", "TEQUAL", "TLPAREN",
-  "TRPAREN", "TLBRACE", "TRBRACE", "TCOMMA", "TDOT", "SQLBRACE",
-  "SQRBRACE", "TPLUS", "TMINUS", "TMUL", "TDIV", "TRETURN", "TEXTERN",
-  "VAR", "COLON", "FUNCTION", "SEMICOLON", "PROGRAM", "IF", "ELSE", "THEN",
-  "TBEGIN", "TEND", "TDO", "TFOR", "TTO", "ARRAY", "OF", "TFOREACH", "IN",
-  "$accept", "program", "main_stmt", "stmts", "expr_block", "array_decl",
-  "stmt", "block", "var_decl", "idlist", "extern_decl", "func_decl",
-  "func_decl_args", "ident", "numeric", "expr", "call_args", "comparison", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "TIDENTIFIER",
+  "TPRAGMA", "TINTEGER", "TDOUBLE", "TSTRING", "TCEQ", "TCNE", "TCLT",
+  "TCLE", "TCGT", "TCGE", "TEQUAL", "TLPAREN", "TRPAREN", "TLBRACE",
+  "TRBRACE", "TCOMMA", "TDOT", "SQLBRACE", "SQRBRACE", "TPLUS", "TMINUS",
+  "TMUL", "TDIV", "TRETURN", "TEXTERN", "VAR", "COLON", "FUNCTION",
+  "SEMICOLON", "PROGRAM", "IF", "ELSE", "THEN", "TBEGIN", "TEND", "TDO",
+  "TFOR", "TTO", "ARRAY", "OF", "TFOREACH", "IN", "TTYPE", "TRECORD",
+  "TCONST", "TFILE", "$accept", "program", "main_stmt", "decls", "stmts",
+  "expr_block", "array_decl", "dim_list", "const_def", "record_decl",
+  "field_list", "field", "stmt", "loop_stmt", "block", "var_decl",
+  "idlist", "extern_decl", "func_decl", "directives", "func_decl_args",
+  "param_decl", "ident", "numeric", "expr", "assign_rhs", "call_args",
+  "index_list", "comparison", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -77
+#define YYPACT_NINF (-139)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-77)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -1
+#define YYTABLE_NINF (-1)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     134,   -77,   -77,   -77,    18,    18,     1,     1,     1,    18,
-       1,     1,    13,    80,   -77,   -77,   -77,   -77,   -77,    11,
-     -77,   240,   215,   240,     1,    -8,    25,    16,   196,    31,
-      24,   -77,    22,   -77,   -77,    28,    18,    18,    64,   -77,
-     -77,   -77,   -77,   -77,   -77,    18,    18,    18,    18,    18,
-     -77,    62,     1,     1,    38,    53,     3,    70,     1,   -77,
-     116,   -77,   240,    23,   234,    18,    63,    63,   117,   117,
-     240,    53,   -77,   -77,    69,     1,   -77,    49,    57,   -77,
-     240,    18,    55,   -77,   -77,    18,    66,   240,    51,    91,
-     -77,    72,    53,     3,   171,     3,   240,    85,   -77,    78,
-       1,   -77,   -77,    18,   -77,    18,    61,    68,   177,   240,
-       1,    81,     3,   -77,   -77,   -77
+      34,  -139,    54,  -139,  -139,  -139,   157,   157,    85,    85,
+      85,   157,    85,    85,    85,    85,    86,   194,  -139,    22,
+    -139,  -139,  -139,  -139,  -139,  -139,   117,  -139,   390,    85,
+    -139,  -139,   104,   371,   390,    85,    14,  -139,    75,   352,
+      73,    67,   109,    22,   113,  -139,   240,  -139,  -139,   108,
+    -139,   157,   157,    85,   157,   119,  -139,  -139,  -139,  -139,
+    -139,  -139,  -139,   157,   157,   157,   157,   157,    51,  -139,
+     125,    85,     8,    -5,   111,   127,    85,    99,  -139,   286,
+    -139,  -139,   390,   390,    11,   122,   390,    65,   157,   250,
+     250,   175,   175,   390,   -23,    -5,  -139,     2,   123,  -139,
+      85,    85,  -139,   120,  -139,   115,  -139,   390,   157,   141,
+      85,  -139,  -139,  -139,   157,  -139,   157,    55,   390,   135,
+     157,    85,    46,    83,    90,   144,    -5,   111,   327,   111,
+       4,   149,    92,   390,   390,    85,  -139,  -139,   137,   390,
+    -139,   157,    85,    13,    18,    85,  -139,  -139,   157,  -139,
+    -139,   149,  -139,    85,   122,   157,   148,   147,   178,    48,
+      56,  -139,  -139,   333,  -139,  -139,   390,    85,   159,   196,
+     157,    85,   157,    85,    19,   111,   190,    85,  -139,   156,
+    -139,   171,  -139,  -139,  -139,   173,  -139,   191,   193,   165,
+     167,  -139,   157,   205,    85,    85,   160,  -139,  -139,  -139,
+    -139
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
-       0,    29,    30,    31,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,    12,     4,     9,    11,    10,    35,
-      37,    13,     0,    14,     0,     0,    23,     0,     0,     0,
-       0,     1,     0,     2,     5,     0,    44,     0,     0,    47,
-      48,    49,    50,    51,    52,     0,     0,     0,     0,     0,
-      43,     0,     0,     0,     0,    26,     0,     0,     0,    20,
-       0,     3,    45,     0,     0,     0,    40,    41,    38,    39,
-      42,    26,    22,    21,     0,     0,    27,     0,    16,     7,
-       6,     0,     0,    19,    34,     0,    36,    32,     0,     0,
-      23,     0,     0,     0,     0,     0,    46,     0,    24,     0,
-       0,    28,    15,     0,    18,     0,     0,     0,     0,    33,
-       0,     0,     0,     8,    25,    17
+       0,    59,     0,    60,    61,    72,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,    29,    31,
+      28,     4,    36,    25,    27,    26,    65,    71,    32,     0,
+      15,    39,    65,     0,    33,     0,     0,    44,     0,     0,
+       0,     0,     0,    30,     0,     1,     0,     2,     5,     0,
+      19,     0,    80,     0,     0,     0,    62,    85,    86,    87,
+      88,    89,    90,     0,     0,     0,     0,     0,     0,    78,
+       0,     0,     0,    50,     0,     0,     0,     0,    41,     0,
+       6,     3,    18,    81,     0,    67,    83,     0,     0,    75,
+      76,    73,    74,    77,     0,    50,    43,     0,     0,    42,
+       0,     0,    53,     0,    51,    35,     9,     8,     0,     0,
+       0,    40,     7,    64,     0,    69,     0,    66,    79,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    21,     0,    82,    84,     0,    63,    45,     0,    16,
+      12,     0,     0,     0,     0,     0,    52,    34,     0,    38,
+      20,    22,    24,     0,    68,     0,     0,     0,     0,     0,
+       0,    54,    47,     0,    23,    70,    17,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,    10,     0,    14,     0,
+      57,     0,    58,    48,    49,     0,    37,     0,     0,     0,
+       0,    46,     0,     0,     0,     0,     0,    13,    55,    56,
+      11
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
-static const yytype_int8 yypgoto[] =
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
 {
-     -77,   -77,   -77,    84,   -76,   -77,   -10,   -11,   -37,   -77,
-     -77,   -77,    39,     4,   -77,    -4,   -77,   -77
+    -139,  -139,  -139,  -139,  -139,  -109,   212,  -138,   200,  -139,
+    -139,    87,   -15,   216,   -16,   -67,    -4,  -139,  -139,  -139,
+     124,    94,     0,  -139,    41,   -81,  -139,    32,  -139
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
-static const yytype_int8 yydefgoto[] =
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_uint8 yydefgoto[] =
 {
-      -1,    12,    33,    13,    78,    14,    15,    79,    16,    25,
-      17,    18,    77,    19,    20,    21,    63,    49
+       0,    16,    47,    17,    79,   105,    18,   138,    19,    20,
+     130,   131,    21,    22,   106,    23,   132,    24,    25,   174,
+     103,   104,    32,    27,    28,    56,    84,    87,    67
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_uint8 yytable[] =
 {
-      22,    23,    35,    34,     1,    28,     1,     2,     3,    52,
-      24,    26,    27,    31,    29,    30,     4,   102,    76,   104,
-      53,     1,     2,     3,    36,     1,     2,     3,    51,    55,
-      37,     4,    62,    64,    76,     4,   115,    84,    32,    38,
-      85,    66,    67,    68,    69,    70,    61,     5,     6,     7,
-      34,     8,    80,    54,     9,   101,    72,    73,    59,    57,
-      10,    87,    82,    91,    11,    98,    92,    58,    92,    39,
-      40,    41,    42,    43,    44,    71,    65,    94,    74,    90,
-      75,    96,    81,     1,     2,     3,    47,    48,    89,    80,
-      93,    80,    95,     4,    97,    99,   111,   105,   106,   108,
-     100,   109,   110,    32,   107,     5,     6,     7,    80,     8,
-      88,   114,     9,     0,   113,    32,    60,     0,    10,     1,
-       2,     3,    11,    39,    40,    41,    42,    43,    44,     4,
-       0,     0,     0,     0,     0,     0,     0,     1,     2,     3,
-       0,     5,     6,     7,     0,     8,     0,     4,     9,     0,
-       0,     0,    83,     0,    10,     0,     0,     0,    11,     5,
-       6,     7,     0,     8,     0,     0,     9,     0,     0,     0,
-       0,     0,    10,     0,     0,     0,    11,    39,    40,    41,
-      42,    43,    44,    39,    40,    41,    42,    43,    44,     0,
-       0,     0,    45,    46,    47,    48,     0,     0,    45,    46,
-      47,    48,    39,    40,    41,    42,    43,    44,     0,     0,
-     103,     0,     0,     0,   112,     0,     0,    45,    46,    47,
-      48,    39,    40,    41,    42,    43,    44,     0,     0,    50,
-      56,     0,     0,     0,     0,     0,    45,    46,    47,    48,
-      39,    40,    41,    42,    43,    44,    39,    40,    41,    42,
-      43,    44,     0,     0,    86,    45,    46,    47,    48,     0,
-       0,    45,    46,    47,    48
+      26,    49,    48,   157,   115,    36,   102,     1,    35,    37,
+      38,     1,    40,    41,    42,    44,     1,    26,   147,    97,
+     149,     1,   183,   120,   100,    68,    98,   113,   102,    37,
+     114,    80,   179,    71,   181,    70,   136,     1,     2,     3,
+       4,     5,   150,   101,    72,   121,    26,    33,    34,     6,
+      97,   184,    39,    85,    50,   159,    46,    98,     2,   102,
+     160,     7,     8,     9,   112,    10,   186,   141,    11,   170,
+      71,    96,    99,   165,    12,   135,   109,   172,    13,    26,
+      14,    94,    15,    29,   116,    55,    45,   117,     1,   142,
+      73,   171,    82,    83,    12,    86,   123,   124,    13,   173,
+      37,    37,    71,    75,    89,    90,    91,    92,    93,    71,
+      37,    71,    76,   143,     1,   107,     3,     4,     5,    52,
+     144,   140,   153,    77,    53,    54,     6,    51,    81,   118,
+      37,    51,    52,    88,    55,   154,   125,    53,    54,   126,
+      95,   108,   158,    99,   161,   162,   110,    55,    46,   128,
+     127,   137,    55,   164,   126,   133,   155,   134,   185,   156,
+       1,   139,     3,     4,     5,   122,   155,   176,   107,   168,
+     107,   180,     6,   182,   145,   155,   200,   188,   189,   116,
+     129,   152,   139,    57,    58,    59,    60,    61,    62,   163,
+     155,   167,   169,   190,   198,   199,   166,     1,     2,     3,
+       4,     5,   177,   178,   187,   191,   192,   193,   194,     6,
+     195,   139,   197,   139,    30,    43,   107,   151,    31,   119,
+     146,     7,     8,     9,   196,    10,     0,     0,    11,     0,
+       0,    46,     0,    86,    12,     0,     0,     0,    13,     0,
+      14,     0,    15,     1,     2,     3,     4,     5,     0,     0,
+       0,     0,     0,     0,     0,     6,     0,     0,    57,    58,
+      59,    60,    61,    62,     0,     0,     0,     7,     8,     9,
+       0,    10,     0,     0,    11,    65,    66,     0,    78,     0,
+      12,     0,     0,     0,    13,     0,    14,     0,    15,     1,
+       2,     3,     4,     5,     0,     0,     0,     0,     0,     0,
+       0,     6,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     7,     8,     9,     0,    10,     0,     0,
+      11,     0,     0,     0,   111,     0,    12,     0,     0,     0,
+      13,     0,    14,     0,    15,    57,    58,    59,    60,    61,
+      62,    57,    58,    59,    60,    61,    62,     0,     0,     0,
+      63,    64,    65,    66,     0,     0,    63,    64,    65,    66,
+      57,    58,    59,    60,    61,    62,     0,     0,   148,     0,
+       0,     0,   175,     0,     0,    63,    64,    65,    66,    57,
+      58,    59,    60,    61,    62,     0,     0,    69,    74,     0,
+       0,     0,     0,     0,    63,    64,    65,    66,    57,    58,
+      59,    60,    61,    62,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,    63,    64,    65,    66
 };
 
-static const yytype_int8 yycheck[] =
+static const yytype_int16 yycheck[] =
 {
-       4,     5,    13,    13,     3,     9,     3,     4,     5,    17,
-       6,     7,     8,     0,    10,    11,    13,    93,    55,    95,
-      28,     3,     4,     5,    13,     3,     4,     5,    24,    13,
-      19,    13,    36,    37,    71,    13,   112,    14,    35,    28,
-      17,    45,    46,    47,    48,    49,    18,    25,    26,    27,
-      60,    29,    56,    28,    32,    92,    52,    53,    36,    28,
-      38,    65,    58,    14,    42,    14,    17,    43,    17,     6,
-       7,     8,     9,    10,    11,    13,    12,    81,    40,    75,
-      27,    85,    12,     3,     4,     5,    23,    24,    19,    93,
-      33,    95,    37,    13,    28,     4,   107,    12,    20,   103,
-      28,   105,    41,    35,   100,    25,    26,    27,   112,    29,
-      71,    30,    32,    -1,   110,    35,    32,    -1,    38,     3,
-       4,     5,    42,     6,     7,     8,     9,    10,    11,    13,
-      -1,    -1,    -1,    -1,    -1,    -1,    -1,     3,     4,     5,
-      -1,    25,    26,    27,    -1,    29,    -1,    13,    32,    -1,
-      -1,    -1,    36,    -1,    38,    -1,    -1,    -1,    42,    25,
-      26,    27,    -1,    29,    -1,    -1,    32,    -1,    -1,    -1,
-      -1,    -1,    38,    -1,    -1,    -1,    42,     6,     7,     8,
-       9,    10,    11,     6,     7,     8,     9,    10,    11,    -1,
-      -1,    -1,    21,    22,    23,    24,    -1,    -1,    21,    22,
-      23,    24,     6,     7,     8,     9,    10,    11,    -1,    -1,
-      39,    -1,    -1,    -1,    37,    -1,    -1,    21,    22,    23,
-      24,     6,     7,     8,     9,    10,    11,    -1,    -1,    14,
-      34,    -1,    -1,    -1,    -1,    -1,    21,    22,    23,    24,
-       6,     7,     8,     9,    10,    11,     6,     7,     8,     9,
-      10,    11,    -1,    -1,    20,    21,    22,    23,    24,    -1,
-      -1,    21,    22,    23,    24
+       0,    17,    17,   141,    85,     9,    73,     3,     8,     9,
+      10,     3,    12,    13,    14,    15,     3,    17,   127,    42,
+     129,     3,     3,    21,    29,    29,    49,    16,    95,    29,
+      19,    46,   170,    19,   172,    35,   117,     3,     4,     5,
+       6,     7,    38,    48,    30,    43,    46,     6,     7,    15,
+      42,    32,    11,    53,    32,    42,    37,    49,     4,   126,
+      42,    27,    28,    29,    79,    31,   175,    21,    34,    21,
+      19,    71,    72,   154,    40,    20,    76,    21,    44,    79,
+      46,    30,    48,    29,    19,    30,     0,    22,     3,    43,
+      15,    43,    51,    52,    40,    54,   100,   101,    44,    43,
+     100,   101,    19,    30,    63,    64,    65,    66,    67,    19,
+     110,    19,    45,    30,     3,    74,     5,     6,     7,    15,
+      30,   121,    30,    14,    20,    21,    15,    14,    20,    88,
+     130,    14,    15,    14,    30,   135,    16,    20,    21,    19,
+      15,    14,   142,   143,   144,   145,    47,    30,    37,   108,
+      35,    16,    30,   153,    19,   114,    19,   116,   174,    22,
+       3,   120,     5,     6,     7,    42,    19,   167,   127,    22,
+     129,   171,    15,   173,    30,    19,    16,   177,    22,    19,
+      39,    32,   141,     8,     9,    10,    11,    12,    13,   148,
+      19,    43,    14,    22,   194,   195,   155,     3,     4,     5,
+       6,     7,    43,     7,    14,    32,    15,    14,    43,    15,
+      43,   170,     7,   172,     2,    15,   175,   130,     2,    95,
+     126,    27,    28,    29,   192,    31,    -1,    -1,    34,    -1,
+      -1,    37,    -1,   192,    40,    -1,    -1,    -1,    44,    -1,
+      46,    -1,    48,     3,     4,     5,     6,     7,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    15,    -1,    -1,     8,     9,
+      10,    11,    12,    13,    -1,    -1,    -1,    27,    28,    29,
+      -1,    31,    -1,    -1,    34,    25,    26,    -1,    38,    -1,
+      40,    -1,    -1,    -1,    44,    -1,    46,    -1,    48,     3,
+       4,     5,     6,     7,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    15,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    27,    28,    29,    -1,    31,    -1,    -1,
+      34,    -1,    -1,    -1,    38,    -1,    40,    -1,    -1,    -1,
+      44,    -1,    46,    -1,    48,     8,     9,    10,    11,    12,
+      13,     8,     9,    10,    11,    12,    13,    -1,    -1,    -1,
+      23,    24,    25,    26,    -1,    -1,    23,    24,    25,    26,
+       8,     9,    10,    11,    12,    13,    -1,    -1,    41,    -1,
+      -1,    -1,    39,    -1,    -1,    23,    24,    25,    26,     8,
+       9,    10,    11,    12,    13,    -1,    -1,    16,    36,    -1,
+      -1,    -1,    -1,    -1,    23,    24,    25,    26,     8,     9,
+      10,    11,    12,    13,    -1,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    23,    24,    25,    26
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
-       0,     3,     4,     5,    13,    25,    26,    27,    29,    32,
-      38,    42,    45,    47,    49,    50,    52,    54,    55,    57,
-      58,    59,    59,    59,    57,    53,    57,    57,    59,    57,
-      57,     0,    35,    46,    50,    51,    13,    19,    28,     6,
-       7,     8,     9,    10,    11,    21,    22,    23,    24,    61,
-      14,    57,    17,    28,    28,    13,    34,    28,    43,    36,
-      47,    18,    59,    60,    59,    12,    59,    59,    59,    59,
-      59,    13,    57,    57,    40,    27,    52,    56,    48,    51,
-      59,    12,    57,    36,    14,    17,    20,    59,    56,    19,
-      57,    14,    17,    33,    59,    37,    59,    28,    14,     4,
-      28,    52,    48,    39,    48,    12,    20,    57,    59,    59,
-      41,    51,    37,    57,    30,    48
+       0,     3,     4,     5,     6,     7,    15,    27,    28,    29,
+      31,    34,    40,    44,    46,    48,    51,    53,    56,    58,
+      59,    62,    63,    65,    67,    68,    72,    73,    74,    29,
+      56,    63,    72,    74,    74,    72,    66,    72,    72,    74,
+      72,    72,    72,    58,    72,     0,    37,    52,    62,    64,
+      32,    14,    15,    20,    21,    30,    75,     8,     9,    10,
+      11,    12,    13,    23,    24,    25,    26,    78,    66,    16,
+      72,    19,    30,    15,    36,    30,    45,    14,    38,    54,
+      62,    20,    74,    74,    76,    72,    74,    77,    14,    74,
+      74,    74,    74,    74,    30,    15,    72,    42,    49,    72,
+      29,    48,    65,    70,    71,    55,    64,    74,    14,    72,
+      47,    38,    62,    16,    19,    75,    19,    22,    74,    70,
+      21,    43,    42,    66,    66,    16,    19,    35,    74,    39,
+      60,    61,    66,    74,    74,    20,    75,    16,    57,    74,
+      72,    21,    43,    30,    30,    30,    71,    55,    41,    55,
+      38,    61,    32,    30,    72,    19,    22,    57,    72,    42,
+      42,    72,    72,    74,    72,    75,    74,    43,    22,    14,
+      21,    43,    21,    43,    69,    39,    72,    43,     7,    57,
+      72,    57,    72,     3,    32,    64,    55,    14,    72,    22,
+      22,    32,    15,    14,    43,    43,    77,     7,    72,    72,
+      16
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    44,    45,    46,    47,    47,    48,    48,    49,    50,
-      50,    50,    50,    50,    50,    50,    50,    50,    50,    51,
-      51,    52,    53,    53,    54,    55,    56,    56,    56,    57,
-      58,    58,    59,    59,    59,    59,    59,    59,    59,    59,
-      59,    59,    59,    59,    60,    60,    60,    61,    61,    61,
-      61,    61,    61
+       0,    50,    51,    52,    53,    53,    54,    54,    55,    55,
+      56,    56,    56,    56,    56,    56,    57,    57,    58,    58,
+      59,    60,    60,    61,    61,    62,    62,    62,    62,    62,
+      62,    62,    62,    62,    62,    62,    62,    63,    63,    63,
+      64,    64,    65,    66,    66,    67,    68,    69,    69,    69,
+      70,    70,    70,    71,    71,    71,    71,    71,    71,    72,
+      73,    73,    74,    74,    74,    74,    74,    74,    74,    74,
+      74,    74,    74,    74,    74,    74,    74,    74,    74,    75,
+      76,    76,    76,    77,    77,    78,    78,    78,    78,    78,
+      78
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
-       0,     2,     2,     2,     1,     2,     1,     1,     9,     1,
-       1,     1,     1,     1,     2,     6,     4,     9,     6,     3,
-       2,     4,     3,     1,     6,     9,     0,     1,     3,     1,
-       1,     1,     4,     7,     4,     1,     4,     1,     3,     3,
-       3,     3,     3,     3,     0,     1,     3,     1,     1,     1,
-       1,     1,     1
+       0,     2,     2,     2,     1,     2,     1,     2,     1,     1,
+       9,    13,     6,    12,     9,     2,     1,     3,     3,     2,
+       6,     1,     2,     3,     2,     1,     1,     1,     1,     1,
+       2,     1,     1,     2,     6,     4,     1,     9,     6,     2,
+       3,     2,     4,     3,     1,     6,    10,     0,     2,     2,
+       0,     1,     3,     1,     4,     9,     9,     6,     6,     1,
+       1,     1,     2,     5,     4,     1,     4,     3,     6,     4,
+       7,     1,     1,     3,     3,     3,     3,     3,     3,     3,
+       0,     1,     3,     1,     3,     1,     1,     1,     1,     1,
+       1
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (YY_("syntax error: cannot back up")); \
-      YYERROR;                                                  \
-    }                                                           \
-while (0)
-
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -750,55 +945,52 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value); \
+                  Kind, Value); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
 
 
-/*----------------------------------------.
-| Print this symbol's value on YYOUTPUT.  |
-`----------------------------------------*/
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-  YYUSE (yytype);
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
-  YYFPRINTF (yyoutput, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -807,7 +999,7 @@ yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep)
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -830,21 +1022,21 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, int yyrule)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
 {
-  unsigned long int yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &(yyvsp[(yyi + 1) - (yynrhs)])
-                                              );
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -859,8 +1051,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -883,249 +1075,30 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-static YYSIZE_T
-yystrlen (const char *yystr)
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
 
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
 
-  return yyd - 1;
-}
-#  endif
-# endif
 
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            /* Fall through.  */
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
-
-  if (! yyres)
-    return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
-
-  {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
 {
-  YYUSE (yyvaluep);
+  YY_USE (yyvaluep);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-
-
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 /* The semantic value of the lookahead symbol.  */
@@ -1134,6 +1107,8 @@ YYSTYPE yylval;
 int yynerrs;
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1141,43 +1116,36 @@ int yynerrs;
 int
 yyparse (void)
 {
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
-
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    int yyerrstatus = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1185,71 +1153,75 @@ yyparse (void)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
 
         /* Each stack pointer address is followed by the size of the
            data in use in that stack, in bytes.  This used to be a
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
                     &yystacksize);
-
         yyss = yyss1;
         yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
@@ -1257,30 +1229,31 @@ yyparse (void)
           YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1291,18 +1264,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex ();
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1330,15 +1314,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
   goto yynewstate;
 
 
@@ -1353,7 +1335,7 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
@@ -1373,270 +1355,567 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 2:
-#line 68 "parser.y" /* yacc.c:1646  */
-    { 
-			programBlock = (yyvsp[-1].block); 
-			for(int i=0;i<(yyvsp[0].block)->statements.size();i++){
-				programBlock->statements.push_back((yyvsp[0].block)->statements[i]);
+  case 2: /* program: decls main_stmt  */
+#line 120 "parser.y"
+                { 
+			if (streamContext != NULL) {
+				// 前面的语句都已经生成过了，只剩主程序
+				programBlock = (yyvsp[0].block);
+			}
+			else {
+				for(int i=0;i<(yyvsp[0].block)->statements.size();i++){
+					(yyvsp[-1].stmtvec)->push_back((yyvsp[0].block)->statements[i]);
+				}
+				programBlock = new NBlock(*(yyvsp[-1].stmtvec));
 			}
 		}
-#line 1385 "parser.cpp" /* yacc.c:1646  */
+#line 1373 "parser.cpp"
     break;
 
-  case 3:
-#line 77 "parser.y" /* yacc.c:1646  */
-    { (yyval.block) = (yyvsp[-1].block);}
-#line 1391 "parser.cpp" /* yacc.c:1646  */
+  case 3: /* main_stmt: block TDOT  */
+#line 135 "parser.y"
+                       { (yyval.block) = (yyvsp[-1].block);}
+#line 1379 "parser.cpp"
     break;
 
-  case 4:
-#line 79 "parser.y" /* yacc.c:1646  */
-    { (yyval.block) = new NBlock(); (yyval.block)->statements.push_back((yyvsp[0].stmt)); }
-#line 1397 "parser.cpp" /* yacc.c:1646  */
+  case 4: /* decls: stmt  */
+#line 137 "parser.y"
+             { (yyval.stmtvec) = topLevel(NULL, (yyvsp[0].stmt)); }
+#line 1385 "parser.cpp"
     break;
 
-  case 5:
-#line 80 "parser.y" /* yacc.c:1646  */
-    { (yyvsp[-1].block)->statements.push_back((yyvsp[0].stmt)); }
-#line 1403 "parser.cpp" /* yacc.c:1646  */
+  case 5: /* decls: decls stmt  */
+#line 138 "parser.y"
+                       { (yyval.stmtvec) = topLevel((yyvsp[-1].stmtvec), (yyvsp[0].stmt)); }
+#line 1391 "parser.cpp"
     break;
 
-  case 6:
-#line 83 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[0].expr) ;}
-#line 1409 "parser.cpp" /* yacc.c:1646  */
+  case 6: /* stmts: stmt  */
+#line 141 "parser.y"
+             { (yyval.stmtvec) = astArena.make<StatementList>(); checkConstSection(false, (yyvsp[0].stmt)); (yyval.stmtvec)->push_back((yyvsp[0].stmt)); }
+#line 1397 "parser.cpp"
     break;
 
-  case 7:
-#line 84 "parser.y" /* yacc.c:1646  */
-    {(yyval.expr) = (yyvsp[0].block);}
-#line 1415 "parser.cpp" /* yacc.c:1646  */
+  case 7: /* stmts: stmts stmt  */
+#line 142 "parser.y"
+                       { checkConstSection(endsWithConst((yyvsp[-1].stmtvec)), (yyvsp[0].stmt)); (yyvsp[-1].stmtvec)->push_back((yyvsp[0].stmt)); }
+#line 1403 "parser.cpp"
     break;
 
-  case 8:
-#line 87 "parser.y" /* yacc.c:1646  */
-    { (yyval.array_decl) = new NArrayDeclaration(*(yyvsp[0].ident), *(yyvsp[-7].ident), std::stoi(*(yyvsp[-3].string)) ); }
-#line 1421 "parser.cpp" /* yacc.c:1646  */
+  case 8: /* expr_block: expr  */
+#line 145 "parser.y"
+                  { (yyval.expr) = (yyvsp[0].expr) ;}
+#line 1409 "parser.cpp"
     break;
 
-  case 13:
-#line 91 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new NExpressionStatement(*(yyvsp[0].expr)); }
-#line 1427 "parser.cpp" /* yacc.c:1646  */
+  case 9: /* expr_block: block  */
+#line 146 "parser.y"
+                {(yyval.expr) = (yyvsp[0].block);}
+#line 1415 "parser.cpp"
     break;
 
-  case 14:
-#line 92 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new NReturnStatement(*(yyvsp[0].expr)); }
-#line 1433 "parser.cpp" /* yacc.c:1646  */
+  case 10: /* array_decl: VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident  */
+#line 149 "parser.y"
+                                                                        {
+			(yyval.array_decl) = new NArrayDeclarationS();
+			ExpressionRange dims(*(yyvsp[-3].exprvec));
+			for(int i=0;i<(yyvsp[-7].identlist)->size();i++){
+				((yyval.array_decl)->ArrayDeclarationList).push_back(new NArrayDeclaration( *(yyvsp[0].ident), *(*(yyvsp[-7].identlist))[i], dims ));
+			}
+		}
+#line 1427 "parser.cpp"
     break;
 
-  case 15:
-#line 93 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new NIFStatement(*(yyvsp[-4].expr),*(yyvsp[-2].expr),*(yyvsp[0].expr)); }
-#line 1439 "parser.cpp" /* yacc.c:1646  */
+  case 11: /* array_decl: VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident TEQUAL TLPAREN index_list TRPAREN  */
+#line 156 "parser.y"
+                                                                                                   {
+			(yyval.array_decl) = new NArrayDeclarationS();
+			ExpressionRange dims(*(yyvsp[-7].exprvec)), initializer(*(yyvsp[-1].exprvec));
+			for(int i=0;i<(yyvsp[-11].identlist)->size();i++){
+				((yyval.array_decl)->ArrayDeclarationList).push_back(new NArrayDeclaration( *(yyvsp[-4].ident), *(*(yyvsp[-11].identlist))[i], dims ));
+				((yyval.array_decl)->ArrayDeclarationList).back()->initializer = initializer;
+			}
+		}
+#line 1440 "parser.cpp"
     break;
 
-  case 16:
-#line 94 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new NIFStatement(*(yyvsp[-2].expr),*(yyvsp[0].expr),*(yyvsp[0].expr)); }
-#line 1445 "parser.cpp" /* yacc.c:1646  */
+  case 12: /* array_decl: VAR idlist COLON ARRAY OF ident  */
+#line 164 "parser.y"
+                                      {
+			(yyval.array_decl) = new NArrayDeclarationS();
+			for(int i=0;i<(yyvsp[-4].identlist)->size();i++){
+				((yyval.array_decl)->ArrayDeclarationList).push_back(new NArrayDeclaration( *(yyvsp[0].ident), *(*(yyvsp[-4].identlist))[i], ExpressionRange() ));
+			}
+		}
+#line 1451 "parser.cpp"
     break;
 
-  case 17:
-#line 95 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new FORStatement(*(yyvsp[-7].ident),*(yyvsp[-4].expr),*(yyvsp[-2].expr),*(yyvsp[0].expr));}
-#line 1451 "parser.cpp" /* yacc.c:1646  */
+  case 13: /* array_decl: VAR idlist COLON TFILE ARRAY SQLBRACE dim_list SQRBRACE OF ident TEQUAL TSTRING  */
+#line 170 "parser.y"
+                                                                                      {
+			(yyval.array_decl) = new NArrayDeclarationS();
+			ExpressionRange dims(*(yyvsp[-5].exprvec));
+			for(int i=0;i<(yyvsp[-10].identlist)->size();i++){
+				((yyval.array_decl)->ArrayDeclarationList).push_back(new NArrayDeclaration( *(yyvsp[-2].ident), *(*(yyvsp[-10].identlist))[i], dims ));
+				((yyval.array_decl)->ArrayDeclarationList).back()->file = *(yyvsp[0].string);
+			}
+			delete (yyvsp[0].string);
+		}
+#line 1465 "parser.cpp"
     break;
 
-  case 18:
-#line 96 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new FOREACHStatement(*(yyvsp[-4].ident),*(yyvsp[-2].ident),*(yyvsp[0].expr));}
-#line 1457 "parser.cpp" /* yacc.c:1646  */
+  case 14: /* array_decl: VAR idlist COLON TFILE ARRAY OF ident TEQUAL TSTRING  */
+#line 179 "parser.y"
+                                                           {
+			(yyval.array_decl) = new NArrayDeclarationS();
+			for(int i=0;i<(yyvsp[-7].identlist)->size();i++){
+				((yyval.array_decl)->ArrayDeclarationList).push_back(new NArrayDeclaration( *(yyvsp[-2].ident), *(*(yyvsp[-7].identlist))[i], ExpressionRange() ));
+				((yyval.array_decl)->ArrayDeclarationList).back()->file = *(yyvsp[0].string);
+			}
+			delete (yyvsp[0].string);
+		}
+#line 1478 "parser.cpp"
     break;
 
-  case 19:
-#line 99 "parser.y" /* yacc.c:1646  */
-    { (yyval.block) = (yyvsp[-1].block); }
-#line 1463 "parser.cpp" /* yacc.c:1646  */
+  case 15: /* array_decl: TPRAGMA array_decl  */
+#line 187 "parser.y"
+                         {
+			for(int i=0;i<(yyvsp[0].array_decl)->ArrayDeclarationList.size();i++){
+				NArrayDeclaration *decl = (yyvsp[0].array_decl)->ArrayDeclarationList[i];
+				decl->pragmas.insert(decl->pragmas.begin(), *(yyvsp[-1].name));
+			}
+			(yyval.array_decl) = (yyvsp[0].array_decl);
+		}
+#line 1490 "parser.cpp"
     break;
 
-  case 20:
-#line 100 "parser.y" /* yacc.c:1646  */
-    { std::cout<<"111"<<std::endl; (yyval.block) = new NBlock(); }
-#line 1469 "parser.cpp" /* yacc.c:1646  */
+  case 16: /* dim_list: expr  */
+#line 196 "parser.y"
+                { (yyval.exprvec) = astArena.make<ExpressionList>(); (yyval.exprvec)->push_back((yyvsp[0].expr)); }
+#line 1496 "parser.cpp"
     break;
 
-  case 21:
-#line 103 "parser.y" /* yacc.c:1646  */
-    {
+  case 17: /* dim_list: dim_list TCOMMA expr  */
+#line 197 "parser.y"
+                               { (yyvsp[-2].exprvec)->push_back((yyvsp[0].expr)); }
+#line 1502 "parser.cpp"
+    break;
+
+  case 18: /* const_def: ident TEQUAL expr  */
+#line 200 "parser.y"
+                              { (yyval.const_decl) = new NConstDeclaration(*(yyvsp[-2].ident), *(yyvsp[0].expr)); }
+#line 1508 "parser.cpp"
+    break;
+
+  case 19: /* const_def: const_def SEMICOLON  */
+#line 201 "parser.y"
+                              { (yyval.const_decl) = (yyvsp[-1].const_decl); }
+#line 1514 "parser.cpp"
+    break;
+
+  case 20: /* record_decl: TTYPE ident TEQUAL TRECORD field_list TEND  */
+#line 204 "parser.y"
+                                                         { (yyval.stmt) = new NRecordDeclaration(*(yyvsp[-4].ident), *(yyvsp[-1].varvec)); }
+#line 1520 "parser.cpp"
+    break;
+
+  case 21: /* field_list: field  */
+#line 207 "parser.y"
+                   { (yyval.varvec) = (yyvsp[0].varvec); }
+#line 1526 "parser.cpp"
+    break;
+
+  case 22: /* field_list: field_list field  */
+#line 208 "parser.y"
+                           { (yyvsp[-1].varvec)->insert((yyvsp[-1].varvec)->end(), (yyvsp[0].varvec)->begin(), (yyvsp[0].varvec)->end()); }
+#line 1532 "parser.cpp"
+    break;
+
+  case 23: /* field: idlist COLON ident  */
+#line 211 "parser.y"
+                           {
+			(yyval.varvec) = astArena.make<VariableList>();
+			for(int i=0;i<(yyvsp[-2].identlist)->size();i++){
+				(yyval.varvec)->push_back(new NVariableDeclaration( *(yyvsp[0].ident), *(*(yyvsp[-2].identlist))[i] ));
+			}
+		}
+#line 1543 "parser.cpp"
+    break;
+
+  case 24: /* field: field SEMICOLON  */
+#line 217 "parser.y"
+                          { (yyval.varvec) = (yyvsp[-1].varvec); }
+#line 1549 "parser.cpp"
+    break;
+
+  case 29: /* stmt: array_decl  */
+#line 221 "parser.y"
+                      { (yyval.stmt) = (yyvsp[0].array_decl); }
+#line 1555 "parser.cpp"
+    break;
+
+  case 30: /* stmt: TCONST const_def  */
+#line 222 "parser.y"
+                            { (yyval.stmt) = (yyvsp[0].const_decl); }
+#line 1561 "parser.cpp"
+    break;
+
+  case 31: /* stmt: const_def  */
+#line 223 "parser.y"
+                     { (yyvsp[0].const_decl)->continued = true; (yyval.stmt) = (yyvsp[0].const_decl); }
+#line 1567 "parser.cpp"
+    break;
+
+  case 32: /* stmt: expr  */
+#line 224 "parser.y"
+                { (yyval.stmt) = new NExpressionStatement(*(yyvsp[0].expr)); }
+#line 1573 "parser.cpp"
+    break;
+
+  case 33: /* stmt: TRETURN expr  */
+#line 225 "parser.y"
+                        { (yyval.stmt) = new NReturnStatement(*(yyvsp[0].expr)); }
+#line 1579 "parser.cpp"
+    break;
+
+  case 34: /* stmt: IF expr THEN expr_block ELSE expr_block  */
+#line 226 "parser.y"
+                                                   { (yyval.stmt) = new NIFStatement(*(yyvsp[-4].expr),*(yyvsp[-2].expr),*(yyvsp[0].expr)); }
+#line 1585 "parser.cpp"
+    break;
+
+  case 35: /* stmt: IF expr THEN expr_block  */
+#line 227 "parser.y"
+                                   { (yyval.stmt) = new NIFStatement(*(yyvsp[-2].expr),*(yyvsp[0].expr),*(yyvsp[0].expr)); }
+#line 1591 "parser.cpp"
+    break;
+
+  case 36: /* stmt: loop_stmt  */
+#line 228 "parser.y"
+                     { (yyval.stmt) = (yyvsp[0].loop); }
+#line 1597 "parser.cpp"
+    break;
+
+  case 37: /* loop_stmt: TFOR ident COLON TEQUAL expr TTO expr TDO expr_block  */
+#line 231 "parser.y"
+                                                                 { (yyval.loop) = new FORStatement(*(yyvsp[-7].ident),*(yyvsp[-4].expr),*(yyvsp[-2].expr),*(yyvsp[0].expr));}
+#line 1603 "parser.cpp"
+    break;
+
+  case 38: /* loop_stmt: TFOREACH ident IN ident TDO expr_block  */
+#line 232 "parser.y"
+                                                  { (yyval.loop) = new FOREACHStatement(*(yyvsp[-4].ident),*(yyvsp[-2].ident),*(yyvsp[0].expr));}
+#line 1609 "parser.cpp"
+    break;
+
+  case 39: /* loop_stmt: TPRAGMA loop_stmt  */
+#line 233 "parser.y"
+                             { (yyvsp[0].loop)->pragmas.insert((yyvsp[0].loop)->pragmas.begin(), *(yyvsp[-1].name)); (yyval.loop) = (yyvsp[0].loop); }
+#line 1615 "parser.cpp"
+    break;
+
+  case 40: /* block: TBEGIN stmts TEND  */
+#line 236 "parser.y"
+                          { (yyval.block) = new NBlock(*(yyvsp[-1].stmtvec)); }
+#line 1621 "parser.cpp"
+    break;
+
+  case 41: /* block: TBEGIN TEND  */
+#line 237 "parser.y"
+                        { std::cout<<"111"<<std::endl; (yyval.block) = new NBlock(); }
+#line 1627 "parser.cpp"
+    break;
+
+  case 42: /* var_decl: VAR idlist COLON ident  */
+#line 240 "parser.y"
+                                   {
 	 		(yyval.varlist_decl) = new NVariableDeclarationS();
 			for(int i=0;i<(yyvsp[-2].identlist)->size();i++){
 				((yyval.varlist_decl)->VariableDeclarationList).push_back(new NVariableDeclaration( *(yyvsp[0].ident), *(*(yyvsp[-2].identlist))[i]   ));
 			}
 	  	}
-#line 1480 "parser.cpp" /* yacc.c:1646  */
+#line 1638 "parser.cpp"
     break;
 
-  case 22:
-#line 111 "parser.y" /* yacc.c:1646  */
-    {(yyvsp[-2].identlist)->push_back((yyvsp[0].ident));}
-#line 1486 "parser.cpp" /* yacc.c:1646  */
+  case 43: /* idlist: idlist TCOMMA ident  */
+#line 248 "parser.y"
+                             {(yyvsp[-2].identlist)->push_back((yyvsp[0].ident));}
+#line 1644 "parser.cpp"
     break;
 
-  case 23:
-#line 112 "parser.y" /* yacc.c:1646  */
-    {(yyval.identlist) = new IdentifierList(); (yyval.identlist)->push_back((yyvsp[0].ident)); }
-#line 1492 "parser.cpp" /* yacc.c:1646  */
+  case 44: /* idlist: ident  */
+#line 249 "parser.y"
+                {(yyval.identlist) = astArena.make<IdentifierList>(); (yyval.identlist)->push_back((yyvsp[0].ident)); }
+#line 1650 "parser.cpp"
     break;
 
-  case 24:
-#line 115 "parser.y" /* yacc.c:1646  */
-    { (yyval.stmt) = new NExternDeclaration(*(yyvsp[-4].ident), *(yyvsp[-3].ident), *(yyvsp[-1].varvec)); delete (yyvsp[-1].varvec); }
-#line 1498 "parser.cpp" /* yacc.c:1646  */
+  case 45: /* extern_decl: TEXTERN ident ident TLPAREN func_decl_args TRPAREN  */
+#line 252 "parser.y"
+                { (yyval.stmt) = new NExternDeclaration(*(yyvsp[-4].ident), *(yyvsp[-3].ident), *(yyvsp[-1].varvec)); }
+#line 1656 "parser.cpp"
     break;
 
-  case 25:
-#line 119 "parser.y" /* yacc.c:1646  */
-    { 
-				(yyval.func_decl) = new NFunctionDeclaration(*(yyvsp[-2].ident), *(yyvsp[-7].ident), *(yyvsp[-5].varvec), *(yyvsp[-1].block)); delete (yyvsp[-5].varvec);
-
+  case 46: /* func_decl: FUNCTION ident TLPAREN func_decl_args TRPAREN COLON ident directives block SEMICOLON  */
+#line 256 "parser.y"
+                        { 
+				(yyval.func_decl) = new NFunctionDeclaration(*(yyvsp[-3].ident), *(yyvsp[-8].ident), *(yyvsp[-6].varvec), *(yyvsp[-1].block));
+				(yyval.func_decl)->directives = *(yyvsp[-2].stringvec);
 			 }
-#line 1507 "parser.cpp" /* yacc.c:1646  */
+#line 1665 "parser.cpp"
+    break;
+
+  case 47: /* directives: %empty  */
+#line 262 "parser.y"
+                       { (yyval.stringvec) = astArena.make<std::vector<std::string> >(); }
+#line 1671 "parser.cpp"
+    break;
+
+  case 48: /* directives: directives TIDENTIFIER  */
+#line 263 "parser.y"
+                                           { (yyvsp[-1].stringvec)->push_back(*(yyvsp[0].name)); }
+#line 1677 "parser.cpp"
+    break;
+
+  case 50: /* func_decl_args: %empty  */
+#line 267 "parser.y"
+                            { (yyval.varvec) = astArena.make<VariableList>(); }
+#line 1683 "parser.cpp"
+    break;
+
+  case 51: /* func_decl_args: param_decl  */
+#line 268 "parser.y"
+                               { (yyval.varvec) = (yyvsp[0].varvec); }
+#line 1689 "parser.cpp"
     break;
 
-  case 26:
-#line 125 "parser.y" /* yacc.c:1646  */
-    { (yyval.varvec) = new VariableList(); }
-#line 1513 "parser.cpp" /* yacc.c:1646  */
+  case 52: /* func_decl_args: func_decl_args TCOMMA param_decl  */
+#line 269 "parser.y"
+                                                     { (yyvsp[-2].varvec)->insert((yyvsp[-2].varvec)->end(), (yyvsp[0].varvec)->begin(), (yyvsp[0].varvec)->end()); }
+#line 1695 "parser.cpp"
     break;
 
-  case 27:
-#line 126 "parser.y" /* yacc.c:1646  */
-    { 
-			  (yyval.varvec) = new VariableList(); 
+  case 53: /* param_decl: var_decl  */
+#line 272 "parser.y"
+                      { 
+			  (yyval.varvec) = astArena.make<VariableList>(); 
 			  for(int i=0;i<(yyvsp[0].varlist_decl)->VariableDeclarationList.size();i++){
 				  (yyval.varvec)->push_back((yyvsp[0].varlist_decl)->VariableDeclarationList[i]);
 			  }
 			}
-#line 1524 "parser.cpp" /* yacc.c:1646  */
+#line 1706 "parser.cpp"
     break;
 
-  case 28:
-#line 132 "parser.y" /* yacc.c:1646  */
-    { 
-			  for(int i=0;i<(yyvsp[0].varlist_decl)->VariableDeclarationList.size();i++){
-				  (yyval.varvec)->push_back((yyvsp[0].varlist_decl)->VariableDeclarationList[i]);
+  case 54: /* param_decl: TCONST idlist COLON ident  */
+#line 278 "parser.y"
+                                              {
+			  (yyval.varvec) = astArena.make<VariableList>();
+			  for(int i=0;i<(yyvsp[-2].identlist)->size();i++){
+				  (yyval.varvec)->push_back(new NVariableDeclaration(*(yyvsp[0].ident), *(*(yyvsp[-2].identlist))[i]));
+				  (yyval.varvec)->back()->mode = PARAM_CONST;
+			  }
+			}
+#line 1718 "parser.cpp"
+    break;
+
+  case 55: /* param_decl: VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident  */
+#line 285 "parser.y"
+                                                                               {
+			  (yyval.varvec) = astArena.make<VariableList>();
+			  ExpressionRange dims(*(yyvsp[-3].exprvec));
+			  for(int i=0;i<(yyvsp[-7].identlist)->size();i++){
+				  (yyval.varvec)->push_back(new NArrayParameter(*(yyvsp[0].ident), *(*(yyvsp[-7].identlist))[i], dims, PARAM_VAR));
+			  }
+			}
+#line 1730 "parser.cpp"
+    break;
+
+  case 56: /* param_decl: TCONST idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident  */
+#line 292 "parser.y"
+                                                                                  {
+			  (yyval.varvec) = astArena.make<VariableList>();
+			  ExpressionRange dims(*(yyvsp[-3].exprvec));
+			  for(int i=0;i<(yyvsp[-7].identlist)->size();i++){
+				  (yyval.varvec)->push_back(new NArrayParameter(*(yyvsp[0].ident), *(*(yyvsp[-7].identlist))[i], dims, PARAM_CONST));
 			  }
-		   }
-#line 1534 "parser.cpp" /* yacc.c:1646  */
+			}
+#line 1742 "parser.cpp"
+    break;
+
+  case 57: /* param_decl: VAR idlist COLON ARRAY OF ident  */
+#line 299 "parser.y"
+                                                    {
+			  (yyval.varvec) = astArena.make<VariableList>();
+			  for(int i=0;i<(yyvsp[-4].identlist)->size();i++){
+				  (yyval.varvec)->push_back(new NArrayParameter(*(yyvsp[0].ident), *(*(yyvsp[-4].identlist))[i], ExpressionRange(), PARAM_VAR));
+			  }
+			}
+#line 1753 "parser.cpp"
+    break;
+
+  case 58: /* param_decl: TCONST idlist COLON ARRAY OF ident  */
+#line 305 "parser.y"
+                                                       {
+			  (yyval.varvec) = astArena.make<VariableList>();
+			  for(int i=0;i<(yyvsp[-4].identlist)->size();i++){
+				  (yyval.varvec)->push_back(new NArrayParameter(*(yyvsp[0].ident), *(*(yyvsp[-4].identlist))[i], ExpressionRange(), PARAM_CONST));
+			  }
+			}
+#line 1764 "parser.cpp"
+    break;
+
+  case 59: /* ident: TIDENTIFIER  */
+#line 313 "parser.y"
+                    { (yyval.ident) = new NIdentifier((yyvsp[0].name)); }
+#line 1770 "parser.cpp"
+    break;
+
+  case 60: /* numeric: TINTEGER  */
+#line 316 "parser.y"
+                   { (yyval.expr) = new NInteger((yyvsp[0].integer)); }
+#line 1776 "parser.cpp"
+    break;
+
+  case 61: /* numeric: TDOUBLE  */
+#line 317 "parser.y"
+                          { (yyval.expr) = new NDouble((yyvsp[0].number)); }
+#line 1782 "parser.cpp"
     break;
 
-  case 29:
-#line 139 "parser.y" /* yacc.c:1646  */
-    { (yyval.ident) = new NIdentifier(*(yyvsp[0].string)); delete (yyvsp[0].string); }
-#line 1540 "parser.cpp" /* yacc.c:1646  */
+  case 62: /* expr: ident assign_rhs  */
+#line 320 "parser.y"
+                        { (yyval.expr) = new NAssignment(*(yyvsp[-1].ident), *(yyvsp[0].expr)); }
+#line 1788 "parser.cpp"
     break;
 
-  case 30:
-#line 142 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NInteger(atol((yyvsp[0].string)->c_str())); delete (yyvsp[0].string); }
-#line 1546 "parser.cpp" /* yacc.c:1646  */
+  case 63: /* expr: ident SQLBRACE index_list SQRBRACE assign_rhs  */
+#line 321 "parser.y"
+                                                         { (yyval.expr) = new NArrayAssignment(*(yyvsp[-4].ident), *(yyvsp[-2].exprvec), *(yyvsp[0].expr)); }
+#line 1794 "parser.cpp"
     break;
 
-  case 31:
-#line 143 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NDouble(atof((yyvsp[0].string)->c_str())); delete (yyvsp[0].string); }
-#line 1552 "parser.cpp" /* yacc.c:1646  */
+  case 64: /* expr: ident TLPAREN call_args TRPAREN  */
+#line 322 "parser.y"
+                                           { (yyval.expr) = new NMethodCall(*(yyvsp[-3].ident), *(yyvsp[-1].exprvec)); }
+#line 1800 "parser.cpp"
     break;
 
-  case 32:
-#line 146 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NAssignment(*(yyvsp[-3].ident), *(yyvsp[0].expr)); }
-#line 1558 "parser.cpp" /* yacc.c:1646  */
+  case 65: /* expr: ident  */
+#line 323 "parser.y"
+                 { (yyval.ident) = (yyvsp[0].ident); }
+#line 1806 "parser.cpp"
     break;
 
-  case 33:
-#line 147 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NArrayAssignment(*(yyvsp[-6].ident), *(yyvsp[-4].expr), *(yyvsp[0].expr)); }
-#line 1564 "parser.cpp" /* yacc.c:1646  */
+  case 66: /* expr: ident SQLBRACE index_list SQRBRACE  */
+#line 324 "parser.y"
+                                              {(yyval.expr) = new NArrayRef(*(yyvsp[-3].ident), *(yyvsp[-1].exprvec)); }
+#line 1812 "parser.cpp"
     break;
 
-  case 34:
-#line 148 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NMethodCall(*(yyvsp[-3].ident), *(yyvsp[-1].exprvec)); delete (yyvsp[-1].exprvec); }
-#line 1570 "parser.cpp" /* yacc.c:1646  */
+  case 67: /* expr: ident TDOT ident  */
+#line 325 "parser.y"
+                            { (yyval.expr) = new NFieldRef(*(yyvsp[-2].ident), *(yyvsp[0].ident)); }
+#line 1818 "parser.cpp"
     break;
 
-  case 35:
-#line 149 "parser.y" /* yacc.c:1646  */
-    { (yyval.ident) = (yyvsp[0].ident); }
-#line 1576 "parser.cpp" /* yacc.c:1646  */
+  case 68: /* expr: ident SQLBRACE index_list SQRBRACE TDOT ident  */
+#line 326 "parser.y"
+                                                         { (yyval.expr) = new NFieldRef(*(yyvsp[-5].ident), *(yyvsp[-3].exprvec), *(yyvsp[0].ident)); }
+#line 1824 "parser.cpp"
     break;
 
-  case 36:
-#line 150 "parser.y" /* yacc.c:1646  */
-    {(yyval.expr) = new NArrayRef(*(yyvsp[-3].ident), *(yyvsp[-1].expr));}
-#line 1582 "parser.cpp" /* yacc.c:1646  */
+  case 69: /* expr: ident TDOT ident assign_rhs  */
+#line 327 "parser.y"
+                                       { (yyval.expr) = new NFieldAssignment(*(yyvsp[-3].ident), *(yyvsp[-1].ident), *(yyvsp[0].expr)); }
+#line 1830 "parser.cpp"
     break;
 
-  case 38:
-#line 152 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
-#line 1588 "parser.cpp" /* yacc.c:1646  */
+  case 70: /* expr: ident SQLBRACE index_list SQRBRACE TDOT ident assign_rhs  */
+#line 328 "parser.y"
+                                                                    { (yyval.expr) = new NFieldAssignment(*(yyvsp[-6].ident), *(yyvsp[-4].exprvec), *(yyvsp[-1].ident), *(yyvsp[0].expr)); }
+#line 1836 "parser.cpp"
     break;
 
-  case 39:
-#line 153 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
-#line 1594 "parser.cpp" /* yacc.c:1646  */
+  case 72: /* expr: TSTRING  */
+#line 330 "parser.y"
+                   { (yyval.expr) = new NString(*(yyvsp[0].string)); delete (yyvsp[0].string); }
+#line 1842 "parser.cpp"
     break;
 
-  case 40:
-#line 154 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
-#line 1600 "parser.cpp" /* yacc.c:1646  */
+  case 73: /* expr: expr TMUL expr  */
+#line 331 "parser.y"
+                          { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
+#line 1848 "parser.cpp"
     break;
 
-  case 41:
-#line 155 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
-#line 1606 "parser.cpp" /* yacc.c:1646  */
+  case 74: /* expr: expr TDIV expr  */
+#line 332 "parser.y"
+                          { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
+#line 1854 "parser.cpp"
     break;
 
-  case 42:
-#line 156 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
-#line 1612 "parser.cpp" /* yacc.c:1646  */
+  case 75: /* expr: expr TPLUS expr  */
+#line 333 "parser.y"
+                           { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
+#line 1860 "parser.cpp"
     break;
 
-  case 43:
-#line 157 "parser.y" /* yacc.c:1646  */
-    { (yyval.expr) = (yyvsp[-1].expr); }
-#line 1618 "parser.cpp" /* yacc.c:1646  */
+  case 76: /* expr: expr TMINUS expr  */
+#line 334 "parser.y"
+                            { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
+#line 1866 "parser.cpp"
     break;
 
-  case 44:
-#line 160 "parser.y" /* yacc.c:1646  */
-    { (yyval.exprvec) = new ExpressionList(); }
-#line 1624 "parser.cpp" /* yacc.c:1646  */
+  case 77: /* expr: expr comparison expr  */
+#line 335 "parser.y"
+                                { (yyval.expr) = new NBinaryOperator(*(yyvsp[-2].expr), (yyvsp[-1].token), *(yyvsp[0].expr)); }
+#line 1872 "parser.cpp"
     break;
 
-  case 45:
-#line 161 "parser.y" /* yacc.c:1646  */
-    { (yyval.exprvec) = new ExpressionList(); (yyval.exprvec)->push_back((yyvsp[0].expr)); }
-#line 1630 "parser.cpp" /* yacc.c:1646  */
+  case 78: /* expr: TLPAREN expr TRPAREN  */
+#line 336 "parser.y"
+                            { (yyval.expr) = (yyvsp[-1].expr); }
+#line 1878 "parser.cpp"
     break;
 
-  case 46:
-#line 162 "parser.y" /* yacc.c:1646  */
-    { (yyvsp[-2].exprvec)->push_back((yyvsp[0].expr)); }
-#line 1636 "parser.cpp" /* yacc.c:1646  */
+  case 79: /* assign_rhs: COLON TEQUAL expr  */
+#line 341 "parser.y"
+                               { (yyval.expr) = (yyvsp[0].expr); }
+#line 1884 "parser.cpp"
     break;
 
+  case 80: /* call_args: %empty  */
+#line 344 "parser.y"
+                       { (yyval.exprvec) = astArena.make<ExpressionList>(); }
+#line 1890 "parser.cpp"
+    break;
+
+  case 81: /* call_args: expr  */
+#line 345 "parser.y"
+                         { (yyval.exprvec) = astArena.make<ExpressionList>(); (yyval.exprvec)->push_back((yyvsp[0].expr)); }
+#line 1896 "parser.cpp"
+    break;
+
+  case 82: /* call_args: call_args TCOMMA expr  */
+#line 346 "parser.y"
+                                           { (yyvsp[-2].exprvec)->push_back((yyvsp[0].expr)); }
+#line 1902 "parser.cpp"
+    break;
+
+  case 83: /* index_list: expr  */
+#line 349 "parser.y"
+                  { (yyval.exprvec) = astArena.make<ExpressionList>(); (yyval.exprvec)->push_back((yyvsp[0].expr)); }
+#line 1908 "parser.cpp"
+    break;
+
+  case 84: /* index_list: index_list TCOMMA expr  */
+#line 350 "parser.y"
+                                 { (yyvsp[-2].exprvec)->push_back((yyvsp[0].expr)); }
+#line 1914 "parser.cpp"
+    break;
+
+
+#line 1918 "parser.cpp"
 
-#line 1640 "parser.cpp" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1650,25 +1929,23 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
   /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
@@ -1679,50 +1956,14 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -1751,12 +1992,11 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
-
-  /* Pacify compilers like GCC when the user code never invokes
-     YYERROR and the label yyerrorlab therefore never appears in user
-     code.  */
-  if (/*CONSTCOND*/ 0)
-     goto yyerrorlab;
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -1773,13 +2013,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -1793,7 +2034,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1805,7 +2046,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1816,26 +2057,30 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
-yyreturn:
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -1851,18 +2096,16 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 167 "parser.y" /* yacc.c:1906  */
+
+#line 355 "parser.y"
 
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.4.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -30,6 +31,10 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 #ifndef YY_YY_PARSER_HPP_INCLUDED
 # define YY_YY_PARSER_HPP_INCLUDED
 /* Debug traces.  */
@@ -40,61 +45,71 @@
 extern int yydebug;
 #endif
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    TIDENTIFIER = 258,
-    TINTEGER = 259,
-    TDOUBLE = 260,
-    TCEQ = 261,
-    TCNE = 262,
-    TCLT = 263,
-    TCLE = 264,
-    TCGT = 265,
-    TCGE = 266,
-    TEQUAL = 267,
-    TLPAREN = 268,
-    TRPAREN = 269,
-    TLBRACE = 270,
-    TRBRACE = 271,
-    TCOMMA = 272,
-    TDOT = 273,
-    SQLBRACE = 274,
-    SQRBRACE = 275,
-    TPLUS = 276,
-    TMINUS = 277,
-    TMUL = 278,
-    TDIV = 279,
-    TRETURN = 280,
-    TEXTERN = 281,
-    VAR = 282,
-    COLON = 283,
-    FUNCTION = 284,
-    SEMICOLON = 285,
-    PROGRAM = 286,
-    IF = 287,
-    ELSE = 288,
-    THEN = 289,
-    TBEGIN = 290,
-    TEND = 291,
-    TDO = 292,
-    TFOR = 293,
-    TTO = 294,
-    ARRAY = 295,
-    OF = 296,
-    TFOREACH = 297,
-    IN = 298
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    TIDENTIFIER = 258,             /* TIDENTIFIER  */
+    TPRAGMA = 259,                 /* TPRAGMA  */
+    TINTEGER = 260,                /* TINTEGER  */
+    TDOUBLE = 261,                 /* TDOUBLE  */
+    TSTRING = 262,                 /* TSTRING  */
+    TCEQ = 263,                    /* TCEQ  */
+    TCNE = 264,                    /* TCNE  */
+    TCLT = 265,                    /* TCLT  */
+    TCLE = 266,                    /* TCLE  */
+    TCGT = 267,                    /* TCGT  */
+    TCGE = 268,                    /* TCGE  */
+    TEQUAL = 269,                  /* TEQUAL  */
+    TLPAREN = 270,                 /* TLPAREN  */
+    TRPAREN = 271,                 /* TRPAREN  */
+    TLBRACE = 272,                 /* TLBRACE  */
+    TRBRACE = 273,                 /* TRBRACE  */
+    TCOMMA = 274,                  /* TCOMMA  */
+    TDOT = 275,                    /* TDOT  */
+    SQLBRACE = 276,                /* SQLBRACE  */
+    SQRBRACE = 277,                /* SQRBRACE  */
+    TPLUS = 278,                   /* TPLUS  */
+    TMINUS = 279,                  /* TMINUS  */
+    TMUL = 280,                    /* TMUL  */
+    TDIV = 281,                    /* TDIV  */
+    TRETURN = 282,                 /* TRETURN  */
+    TEXTERN = 283,                 /* TEXTERN  */
+    VAR = 284,                     /* VAR  */
+    COLON = 285,                   /* COLON  */
+    FUNCTION = 286,                /* FUNCTION  */
+    SEMICOLON = 287,               /* SEMICOLON  */
+    PROGRAM = 288,                 /* PROGRAM  */
+    IF = 289,                      /* IF  */
+    ELSE = 290,                    /* ELSE  */
+    THEN = 291,                    /* THEN  */
+    TBEGIN = 292,                  /* TBEGIN  */
+    TEND = 293,                    /* TEND  */
+    TDO = 294,                     /* TDO  */
+    TFOR = 295,                    /* TFOR  */
+    TTO = 296,                     /* TTO  */
+    ARRAY = 297,                   /* ARRAY  */
+    OF = 298,                      /* OF  */
+    TFOREACH = 299,                /* TFOREACH  */
+    IN = 300,                      /* IN  */
+    TTYPE = 301,                   /* TTYPE  */
+    TRECORD = 302,                 /* TRECORD  */
+    TCONST = 303,                  /* TCONST  */
+    TFILE = 304                    /* TFILE  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-
 union YYSTYPE
 {
-#line 14 "parser.y" /* yacc.c:1909  */
+#line 53 "parser.y"
 
 	Node *node;
 	NBlock *block;
@@ -104,18 +119,24 @@ union YYSTYPE
 	NVariableDeclaration *var_decl;
 	NVariableDeclarationS *varlist_decl;
 	NFunctionDeclaration *func_decl;
-	NArrayDeclaration *array_decl;
+	NArrayDeclarationS *array_decl;
+	NConstDeclaration *const_decl;
+	NLoopStatement *loop;
+	std::vector<NStatement*> *stmtvec;
 	std::vector<NVariableDeclaration*> *varvec;
 	std::vector<NVariableDeclarationS*> *varlistvec;
 	std::vector<NExpression*> *exprvec;
 	std::vector<std::string> *stringvec;
 	std::vector<NIdentifier *> *identlist;
 	std::string *string;
+	const std::string *name;
+	long long integer;
+	double number;
 	int token;
 
-#line 117 "parser.hpp" /* yacc.c:1909  */
-};
+#line 138 "parser.hpp"
 
+};
 typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
@@ -124,6 +145,8 @@ typedef union YYSTYPE YYSTYPE;
 
 extern YYSTYPE yylval;
 
+
 int yyparse (void);
 
+
 #endif /* !YY_YY_PARSER_HPP_INCLUDED  */
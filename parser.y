@@ -1,5 +1,6 @@
 %{
 	#include "node.h"
+	#include "codegen.h"
         #include <cstdio>
         #include <cstdlib>
 	#include<vector>
@@ -8,6 +9,44 @@
 
 	extern int yylex();
 	void yyerror(const char *s) { std::printf("Error: %s\n", s);std::exit(1); }
+	/* K = N * 4 without the keyword only continues a const section */
+	static void checkConstSection(bool afterConst, NStatement *stmt) {
+		NConstDeclaration *def = llvm::dyn_cast<NConstDeclaration>(stmt);
+		if (def != NULL && def->continued && !afterConst)
+			yyerror("constant definition outside a const section");
+	}
+	static bool endsWithConst(StatementList *statements) {
+		return !statements->empty() && llvm::isa<NConstDeclaration>(statements->back());
+	}
+
+	/* Streaming: with a context set by startStreaming, every top-level
+	   statement is compiled as soon as it is reduced and its tree is freed
+	   (back to the arena mark taken after the previous one), so only the
+	   main block is kept until the end */
+	static CodeGenContext *streamContext = NULL;
+	static AstArena::Mark streamMark;
+	static bool streamAfterConst = false;
+
+	void startStreaming(CodeGenContext& context) {
+		streamContext = &context;
+		streamMark = astArena.mark();
+	}
+
+	static StatementList *topLevel(StatementList *statements, NStatement *stmt) {
+		if (streamContext == NULL) {
+			if (statements == NULL)
+				statements = astArena.make<StatementList>();
+			checkConstSection(endsWithConst(statements), stmt);
+			statements->push_back(stmt);
+			return statements;
+		}
+		checkConstSection(streamAfterConst, stmt);
+		streamAfterConst = llvm::isa<NConstDeclaration>(stmt);
+		if (streamContext->generateTopLevel(*stmt))
+			astArena.release(streamMark);
+		streamMark = astArena.mark();
+		return NULL;
+	}
 %}
 
 /* Represents the many different ways we can access our data */
@@ -20,13 +59,19 @@
 	NVariableDeclaration *var_decl;
 	NVariableDeclarationS *varlist_decl;
 	NFunctionDeclaration *func_decl;
-	NArrayDeclaration *array_decl;
+	NArrayDeclarationS *array_decl;
+	NConstDeclaration *const_decl;
+	NLoopStatement *loop;
+	std::vector<NStatement*> *stmtvec;
 	std::vector<NVariableDeclaration*> *varvec;
 	std::vector<NVariableDeclarationS*> *varlistvec;
 	std::vector<NExpression*> *exprvec;
 	std::vector<std::string> *stringvec;
 	std::vector<NIdentifier *> *identlist;
 	std::string *string;
+	const std::string *name;
+	long long integer;
+	double number;
 	int token;
 }
 
@@ -34,11 +79,14 @@
    match our tokens.l lex file. We also define the node type
    they represent.
  */
-%token <string> TIDENTIFIER TINTEGER TDOUBLE
+%token <name> TIDENTIFIER TPRAGMA
+%token <integer> TINTEGER
+%token <number> TDOUBLE
+%token <string> TSTRING
 %token <token> TCEQ TCNE TCLT TCLE TCGT TCGE TEQUAL
 %token <token> TLPAREN TRPAREN TLBRACE TRBRACE TCOMMA TDOT SQLBRACE SQRBRACE
 %token <token> TPLUS TMINUS TMUL TDIV 
-%token <token> TRETURN TEXTERN VAR COLON FUNCTION SEMICOLON PROGRAM IF ELSE THEN TBEGIN TEND TDO TFOR TTO ARRAY OF TFOREACH IN
+%token <token> TRETURN TEXTERN VAR COLON FUNCTION SEMICOLON PROGRAM IF ELSE THEN TBEGIN TEND TDO TFOR TTO ARRAY OF TFOREACH IN TTYPE TRECORD TCONST TFILE
 
 /* Define the type of node our nonterminal symbols represent.
    The types refer to the %union declaration above. Ex: when
@@ -46,16 +94,20 @@
    calling an (NIdentifier*). It makes the compiler happy.
  */
 %type <ident> ident
-%type <expr> numeric expr  expr_block
-%type <varvec> func_decl_args
-%type <exprvec> call_args
-%type <block> program stmts block main_stmt
-%type <stmt> stmt extern_decl
+%type <expr> numeric expr  expr_block assign_rhs
+%type <varvec> func_decl_args field_list field param_decl
+%type <exprvec> call_args dim_list index_list
+%type <stringvec> directives
+%type <block> program block main_stmt
+%type <stmtvec> decls stmts
+%type <stmt> stmt extern_decl record_decl
 %type <token> comparison
 %type <identlist> idlist
 %type <varlist_decl> var_decl
 %type <func_decl> func_decl
 %type <array_decl> array_decl
+%type <const_decl> const_def
+%type <loop> loop_stmt
 /* Operator precedence for mathematical operators */
 %left TPLUS TMINUS
 %left TMUL TDIV
@@ -64,11 +116,17 @@
 
 %%
 
-program :  stmts main_stmt 
+program :  decls main_stmt 
 		{ 
-			programBlock = $1; 
-			for(int i=0;i<$2->statements.size();i++){
-				programBlock->statements.push_back($2->statements[i]);
+			if (streamContext != NULL) {
+				// 前面的语句都已经生成过了，只剩主程序
+				programBlock = $2;
+			}
+			else {
+				for(int i=0;i<$2->statements.size();i++){
+					$1->push_back($2->statements[i]);
+				}
+				programBlock = new NBlock(*$1);
 			}
 		}
 		;
@@ -76,27 +134,106 @@ head : PROGRAM ident TLPAREN func_decl_args TRPAREN SEMICOLON {std::cout<<$2<<st
       ; 
 main_stmt : block TDOT { $$ = $1;}
 
-stmts : stmt { $$ = new NBlock(); $$->statements.push_back($<stmt>1); }
-	  | stmts stmt { $1->statements.push_back($<stmt>2); }
+decls : stmt { $$ = topLevel(NULL, $<stmt>1); }
+	  | decls stmt { $$ = topLevel($1, $<stmt>2); }
+	  ;
+
+stmts : stmt { $$ = astArena.make<StatementList>(); checkConstSection(false, $<stmt>1); $$->push_back($<stmt>1); }
+	  | stmts stmt { checkConstSection(endsWithConst($1), $<stmt>2); $1->push_back($<stmt>2); }
 	  ;
 
 expr_block : expr { $$ = $1 ;}
 	| block {$$ = $1;}
 	;
 
-array_decl : VAR ident COLON ARRAY SQLBRACE TINTEGER SQRBRACE OF ident { $$ = new NArrayDeclaration(*$9, *$2, std::stoi(*$6) ); }
+array_decl : VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident {
+			$$ = new NArrayDeclarationS();
+			ExpressionRange dims(*$6);
+			for(int i=0;i<$2->size();i++){
+				($$->ArrayDeclarationList).push_back(new NArrayDeclaration( *$9, *(*$2)[i], dims ));
+			}
+		}
+    | VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident TEQUAL TLPAREN index_list TRPAREN {
+			$$ = new NArrayDeclarationS();
+			ExpressionRange dims(*$6), initializer(*$12);
+			for(int i=0;i<$2->size();i++){
+				($$->ArrayDeclarationList).push_back(new NArrayDeclaration( *$9, *(*$2)[i], dims ));
+				($$->ArrayDeclarationList).back()->initializer = initializer;
+			}
+		}
+    | VAR idlist COLON ARRAY OF ident {
+			$$ = new NArrayDeclarationS();
+			for(int i=0;i<$2->size();i++){
+				($$->ArrayDeclarationList).push_back(new NArrayDeclaration( *$6, *(*$2)[i], ExpressionRange() ));
+			}
+		}
+    | VAR idlist COLON TFILE ARRAY SQLBRACE dim_list SQRBRACE OF ident TEQUAL TSTRING {
+			$$ = new NArrayDeclarationS();
+			ExpressionRange dims(*$7);
+			for(int i=0;i<$2->size();i++){
+				($$->ArrayDeclarationList).push_back(new NArrayDeclaration( *$10, *(*$2)[i], dims ));
+				($$->ArrayDeclarationList).back()->file = *$12;
+			}
+			delete $12;
+		}
+    | VAR idlist COLON TFILE ARRAY OF ident TEQUAL TSTRING {
+			$$ = new NArrayDeclarationS();
+			for(int i=0;i<$2->size();i++){
+				($$->ArrayDeclarationList).push_back(new NArrayDeclaration( *$7, *(*$2)[i], ExpressionRange() ));
+				($$->ArrayDeclarationList).back()->file = *$9;
+			}
+			delete $9;
+		}
+    | TPRAGMA array_decl {
+			for(int i=0;i<$2->ArrayDeclarationList.size();i++){
+				NArrayDeclaration *decl = $2->ArrayDeclarationList[i];
+				decl->pragmas.insert(decl->pragmas.begin(), *$1);
+			}
+			$$ = $2;
+		}
     ;
 
-stmt : var_decl | func_decl | extern_decl | array_decl
+dim_list : expr { $$ = astArena.make<ExpressionList>(); $$->push_back($1); }
+	| dim_list TCOMMA expr { $1->push_back($3); }
+	;
+
+const_def : ident TEQUAL expr { $$ = new NConstDeclaration(*$1, *$3); }
+	| const_def SEMICOLON { $$ = $1; }
+	;
+
+record_decl : TTYPE ident TEQUAL TRECORD field_list TEND { $$ = new NRecordDeclaration(*$2, *$5); }
+    ;
+
+field_list : field { $$ = $1; }
+	| field_list field { $1->insert($1->end(), $2->begin(), $2->end()); }
+	;
+
+field : idlist COLON ident {
+			$$ = astArena.make<VariableList>();
+			for(int i=0;i<$1->size();i++){
+				$$->push_back(new NVariableDeclaration( *$3, *(*$1)[i] ));
+			}
+		}
+	| field SEMICOLON { $$ = $1; }
+	;
+
+stmt : var_decl | func_decl | extern_decl | record_decl
+	 | array_decl { $$ = $1; }
+	 | TCONST const_def { $$ = $2; }
+	 | const_def { $1->continued = true; $$ = $1; }
 	 | expr { $$ = new NExpressionStatement(*$1); }
 	 | TRETURN expr { $$ = new NReturnStatement(*$2); }
 	 | IF expr THEN expr_block ELSE expr_block { $$ = new NIFStatement(*$2,*$4,*$6); }
 	 | IF expr THEN expr_block { $$ = new NIFStatement(*$2,*$4,*$4); }
-	 | TFOR ident COLON TEQUAL expr TTO expr TDO expr_block { $$ = new FORStatement(*$2,*$5,*$7,*$9);}
-	 | TFOREACH ident IN ident TDO expr_block { $$ = new FOREACHStatement(*$2,*$4,*$6);}
+	 | loop_stmt { $$ = $1; }
      ;
 
-block : TBEGIN stmts TEND { $$ = $2; }
+loop_stmt : TFOR ident COLON TEQUAL expr TTO expr TDO expr_block { $$ = new FORStatement(*$2,*$5,*$7,*$9);}
+	 | TFOREACH ident IN ident TDO expr_block { $$ = new FOREACHStatement(*$2,*$4,*$6);}
+	 | TPRAGMA loop_stmt { $2->pragmas.insert($2->pragmas.begin(), *$1); $$ = $2; }
+	 ;
+
+block : TBEGIN stmts TEND { $$ = new NBlock(*$2); }
 	  | TBEGIN TEND { std::cout<<"111"<<std::endl; $$ = new NBlock(); }
 	  ;
 
@@ -109,46 +246,88 @@ var_decl : VAR idlist COLON  ident {
 		;
 
 idlist : idlist TCOMMA ident {$1->push_back($3);}
-	| ident {$$ = new IdentifierList(); $$->push_back($1); }
+	| ident {$$ = astArena.make<IdentifierList>(); $$->push_back($1); }
 
 extern_decl : TEXTERN ident ident TLPAREN func_decl_args TRPAREN
-                { $$ = new NExternDeclaration(*$2, *$3, *$5); delete $5; }
+                { $$ = new NExternDeclaration(*$2, *$3, *$5); }
             ;
 
-func_decl : FUNCTION ident TLPAREN func_decl_args TRPAREN COLON ident  block SEMICOLON
+func_decl : FUNCTION ident TLPAREN func_decl_args TRPAREN COLON ident directives block SEMICOLON
 			{ 
-				$$ = new NFunctionDeclaration(*$7, *$2, *$4, *$8); delete $4;
-
+				$$ = new NFunctionDeclaration(*$7, *$2, *$4, *$9);
+				$$->directives = *$8;
 			 }
 		  ;
+
+directives : /*blank*/ { $$ = astArena.make<std::vector<std::string> >(); }
+		  | directives TIDENTIFIER { $1->push_back(*$2); }
+		  | directives SEMICOLON
+		  ;
 	
-func_decl_args : /*blank*/  { $$ = new VariableList(); }
-		  | var_decl { 
-			  $$ = new VariableList(); 
+func_decl_args : /*blank*/  { $$ = astArena.make<VariableList>(); }
+		  | param_decl { $$ = $1; }
+		  | func_decl_args TCOMMA param_decl { $1->insert($1->end(), $3->begin(), $3->end()); }
+		  ;
+
+param_decl : var_decl { 
+			  $$ = astArena.make<VariableList>(); 
 			  for(int i=0;i<$1->VariableDeclarationList.size();i++){
 				  $$->push_back($1->VariableDeclarationList[i]);
 			  }
 			}
-		  | func_decl_args TCOMMA var_decl { 
-			  for(int i=0;i<$3->VariableDeclarationList.size();i++){
-				  $$->push_back($3->VariableDeclarationList[i]);
+		  | TCONST idlist COLON ident {
+			  $$ = astArena.make<VariableList>();
+			  for(int i=0;i<$2->size();i++){
+				  $$->push_back(new NVariableDeclaration(*$4, *(*$2)[i]));
+				  $$->back()->mode = PARAM_CONST;
+			  }
+			}
+		  | VAR idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident {
+			  $$ = astArena.make<VariableList>();
+			  ExpressionRange dims(*$6);
+			  for(int i=0;i<$2->size();i++){
+				  $$->push_back(new NArrayParameter(*$9, *(*$2)[i], dims, PARAM_VAR));
+			  }
+			}
+		  | TCONST idlist COLON ARRAY SQLBRACE dim_list SQRBRACE OF ident {
+			  $$ = astArena.make<VariableList>();
+			  ExpressionRange dims(*$6);
+			  for(int i=0;i<$2->size();i++){
+				  $$->push_back(new NArrayParameter(*$9, *(*$2)[i], dims, PARAM_CONST));
+			  }
+			}
+		  | VAR idlist COLON ARRAY OF ident {
+			  $$ = astArena.make<VariableList>();
+			  for(int i=0;i<$2->size();i++){
+				  $$->push_back(new NArrayParameter(*$6, *(*$2)[i], ExpressionRange(), PARAM_VAR));
 			  }
-		   }
+			}
+		  | TCONST idlist COLON ARRAY OF ident {
+			  $$ = astArena.make<VariableList>();
+			  for(int i=0;i<$2->size();i++){
+				  $$->push_back(new NArrayParameter(*$6, *(*$2)[i], ExpressionRange(), PARAM_CONST));
+			  }
+			}
 		  ;
 
-ident : TIDENTIFIER { $$ = new NIdentifier(*$1); delete $1; }
+ident : TIDENTIFIER { $$ = new NIdentifier($1); }
 	  ;
 
-numeric : TINTEGER { $$ = new NInteger(atol($1->c_str())); delete $1; }
-		| TDOUBLE { $$ = new NDouble(atof($1->c_str())); delete $1; }
+numeric : TINTEGER { $$ = new NInteger($1); }
+		| TDOUBLE { $$ = new NDouble($1); }
 		;
 	
-expr : ident COLON TEQUAL expr { $$ = new NAssignment(*$<ident>1, *$4); }
-	 | ident SQLBRACE expr SQRBRACE COLON TEQUAL expr { $$ = new NArrayAssignment(*$1, *$3, *$7); }
-	 | ident TLPAREN call_args TRPAREN { $$ = new NMethodCall(*$1, *$3); delete $3; }
+expr : ident assign_rhs { $$ = new NAssignment(*$<ident>1, *$2); }
+	 | ident SQLBRACE index_list SQRBRACE assign_rhs { $$ = new NArrayAssignment(*$1, *$3, *$5); }
+	 | ident TLPAREN call_args TRPAREN { $$ = new NMethodCall(*$1, *$3); }
 	 | ident { $<ident>$ = $1; }
-	 | ident SQLBRACE expr SQRBRACE {$$ = new NArrayRef(*$1, *$3);}
+	 | ident SQLBRACE index_list SQRBRACE {$$ = new NArrayRef(*$1, *$3); }
+	 | ident TDOT ident { $$ = new NFieldRef(*$1, *$3); }
+	 | ident SQLBRACE index_list SQRBRACE TDOT ident { $$ = new NFieldRef(*$1, *$3, *$6); }
+	 | ident TDOT ident assign_rhs { $$ = new NFieldAssignment(*$1, *$3, *$4); }
+	 | ident SQLBRACE index_list SQRBRACE TDOT ident assign_rhs { $$ = new NFieldAssignment(*$1, *$3, *$6, *$7); }
 	 | numeric
+	 | TSTRING { $$ = new NString(*$1); delete $1; }
          | expr TMUL expr { $$ = new NBinaryOperator(*$1, $2, *$3); }
          | expr TDIV expr { $$ = new NBinaryOperator(*$1, $2, *$3); }
          | expr TPLUS expr { $$ = new NBinaryOperator(*$1, $2, *$3); }
@@ -156,12 +335,21 @@ expr : ident COLON TEQUAL expr { $$ = new NAssignment(*$<ident>1, *$4); }
  	 | expr comparison expr { $$ = new NBinaryOperator(*$1, $2, *$3); }
      | TLPAREN expr TRPAREN { $$ = $2; }
 	;
+
+/* shared by every assignment form, so the operators after the value are
+   one set of shift/reduce conflicts instead of one per form */
+assign_rhs : COLON TEQUAL expr { $$ = $3; }
+	;
 	
-call_args : /*blank*/  { $$ = new ExpressionList(); }
-		  | expr { $$ = new ExpressionList(); $$->push_back($1); }
+call_args : /*blank*/  { $$ = astArena.make<ExpressionList>(); }
+		  | expr { $$ = astArena.make<ExpressionList>(); $$->push_back($1); }
 		  | call_args TCOMMA expr  { $1->push_back($3); }
 		  ;
 
+index_list : expr { $$ = astArena.make<ExpressionList>(); $$->push_back($1); }
+	| index_list TCOMMA expr { $1->push_back($3); }
+	;
+
 comparison : TCEQ | TCNE | TCLT | TCLE | TCGT | TCGE;
 
 %%
@@ -0,0 +1,10 @@
+/* Embeds native.bc, the runtime compiled to LLVM bitcode by the Makefile,
+   into the compiler; CodeGenContext::linkRuntime links it into every module */
+__asm__(".section .rodata\n"
+        ".global pascal_runtime_bitcode\n"
+        ".global pascal_runtime_bitcode_end\n"
+        ".balign 16\n"
+        "pascal_runtime_bitcode:\n"
+        ".incbin \"native.bc\"\n"
+        "pascal_runtime_bitcode_end:\n"
+        ".previous\n");